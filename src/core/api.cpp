@@ -1,5 +1,12 @@
 #include "api.h"
+#include "cache.h"
+#include "fields.h"
+#include "sax.h"
+#include "serialize.h"
+#include "../utils/date.h"
+#include "../utils/parallel.h"
 #include "httplib/httplib.h"
+#include <future>
 #include <memory>
 
 namespace fitgalgo
@@ -7,70 +14,38 @@ namespace fitgalgo
 
 DateIdx::DateIdx(const std::string& value)
 {
-    if (value.size() < 10)
-	return;
-
-    if (value.size() >= 19)
-	this->set_datetime_if_valid_value(value.substr(0, 19), "%Y-%m-%dT%H:%M:%S");
+    auto dt = parse_isodatetime(value);
+    if (!dt.has_value())
+	dt = parse_isodate(value);
 
-    if (this->datetime.empty())
-	this->set_datetime_if_valid_value(value.substr(0, 10) + "T00:00:00", "%Y-%m-%d");
-}
-
-void DateIdx::set_datetime_if_valid_value(const std::string& value, const std::string& format)
-{
-    std::tm tm_struct{};
-    std::istringstream iss(value);
-    iss >> std::get_time(&tm_struct, format.c_str());
-    if (!iss.fail())
-	this->datetime = value;
-}
-
-std::chrono::year_month_day DateIdx::ymd() const
-{
-    std::istringstream ss(this->datetime);
-
-    int year, month, day;
-    char dash1, dash2;
-    ss >> year >> dash1 >> month >> dash2 >> day;
-
-    return std::chrono::year(year) / std::chrono::month(month) / std::chrono::day(day);
+    if (dt.has_value())
+	this->packed = pack(dt->year, dt->month, dt->day, dt->hour, dt->minute, dt->second);
 }
 
 inline void DateIdx::decrement_date()
 {
-    auto ymd = this->ymd();
-    auto yesterday = std::chrono::year_month_day(std::chrono::sys_days(ymd) - std::chrono::days(1));
-    std::ostringstream oss;
-    oss << std::setw(4) << std::setfill('0') << static_cast<int>(yesterday.year())
-        << '-' << std::setw(2) << std::setfill('0') << static_cast<unsigned>(yesterday.month())
-	<< '-' << std::setw(2) << std::setfill('0') << static_cast<unsigned>(yesterday.day());
-    this->datetime = oss.str();
-}
-
-const std::string &DateIdx::value() const
-{
-    return this->datetime;
+    const std::chrono::year_month_day yesterday{std::chrono::sys_days(this->ymd()) - std::chrono::days(1)};
+    this->packed = pack(
+	static_cast<int>(yesterday.year()),
+	static_cast<unsigned>(yesterday.month()),
+	static_cast<unsigned>(yesterday.day()));
 }
 
-short DateIdx::year() const
+std::string DateIdx::value() const
 {
-    return is_valid() ? static_cast<short>(std::atoi(datetime.substr(0, 4).c_str())) : -1;
-}
+    if (!this->is_valid())
+	return {};
 
-short DateIdx::month() const
-{
-    return is_valid() ? static_cast<short>(std::atoi(datetime.substr(5, 2).c_str())) : -1;
-}
-
-short DateIdx::day() const
-{
-    return is_valid() ? static_cast<short>(std::atoi(datetime.substr(8, 2).c_str())) : -1;
-}
-
-bool DateIdx::is_valid() const
-{
-    return !this->datetime.empty();
+    std::string datetime(19, '\0');
+    format_isodatetime(
+	{this->year(),
+	 static_cast<unsigned>(this->month()),
+	 static_cast<unsigned>(this->day()),
+	 static_cast<unsigned>(this->hour()),
+	 static_cast<unsigned>(this->minute()),
+	 static_cast<unsigned>(this->second())},
+	datetime.data());
+    return datetime;
 }
 
 DateIdx& DateIdx::operator--()
@@ -85,12 +60,7 @@ DateIdx& DateIdx::operator--(int)
     return *this;
 }
 
-bool operator<(const DateIdx& l, const DateIdx& r)
-{
-    return l.datetime < r.datetime;
-}
-
-bool LoginData::load(const rapidjson::Document& document)
+bool LoginData::load(const rapidjson::Value& document)
 {
     const auto at_member = document.FindMember("access_token");
     if (at_member == document.MemberEnd() || !at_member->value.IsString())
@@ -108,7 +78,7 @@ bool LoginData::load(const rapidjson::Document& document)
     return true;
 }
 
-bool UploadedFileData::load(const rapidjson::Document& document)
+bool UploadedFileData::load(const rapidjson::Value& document)
 {
     const auto data = document.FindMember("data");
     if (data == document.MemberEnd() || !data->value.IsArray())
@@ -159,51 +129,21 @@ bool UploadedFileData::load(const rapidjson::Document& document)
     return true;
 }
 
-bool StepsData::load(const rapidjson::Document& document)
+DateIdx StepsData::newest() const
 {
-    const auto data = document.FindMember("data");
-    if (data == document.MemberEnd() || !data->value.IsArray())
-    {
-	return false;
-    }
-
-    for (const auto& v : data->value.GetArray())
-    {
-	DateIdx idx{v["datetime_local"].GetString()};
-	if (v.IsObject() && v.HasMember("datetime_local") && idx.is_valid())
-	{
-	    auto itr_dt_utc = v.FindMember("datetime_utc");
-	    auto itr_dt_local = v.FindMember("datetime_local");
-	    auto itr_steps = v.FindMember("total_steps");
-	    auto itr_distance = v.FindMember("total_distance");
-	    auto itr_calories = v.FindMember("total_calories");
-
-	    struct Steps item{};
-
-	    item.datetime_local = itr_dt_local->value.GetString();
-
-	    if (itr_dt_utc != v.MemberEnd() && itr_dt_utc->value.IsString())
-		item.datetime_utc = itr_dt_utc->value.GetString();
-
-	    if (itr_steps != v.MemberEnd() && itr_steps->value.IsInt())
-		item.steps = itr_steps->value.GetInt();
-
-            if (itr_distance != v.MemberEnd() && itr_distance->value.IsFloat())
-		item.distance = itr_distance->value.GetFloat();
-
-	    if (itr_calories != v.MemberEnd() && itr_calories->value.IsInt())
-		item.calories = itr_calories->value.GetInt();
+    return this->steps.empty() ? DateIdx() : this->steps.rbegin()->first;
+}
 
-	    this->steps[idx] = item;
-	}
-	else
-	{
-	    this->errors.emplace_back(
-		"JSON error: a datetime_local item is not an object, not exists or is not valid");
-	}
-    }
+void StepsData::merge(StepsData&& other)
+{
+    for (auto& [idx, item] : other.steps)
+	this->steps.insert_or_assign(idx, std::move(item));
+    this->errors = std::move(other.errors);
+}
 
-    return true;
+bool StepsData::includes(const StepsData& other) const
+{
+    return this->errors == other.errors && this->steps.includes(other.steps);
 }
 
 bool Sleep::is_early_morning() const
@@ -211,18 +151,28 @@ bool Sleep::is_early_morning() const
     if (this->dates.size() != 2)
 	return false;
 
-    if (this->dates[0].size() < 13)
-	return false;
+    const int hour = parse_digits(this->dates[0], 11, 2);
+    return hour >= 0 && hour <= 6;
+}
 
-    std::stringstream ss{this->dates[0].substr(11, 2)};
-    unsigned short num;
-    if (ss >> num && num <= 6)
-	return true;
-    else
-	return false;
+DateIdx SleepData::newest() const
+{
+    return this->sleep.empty() ? DateIdx() : this->sleep.rbegin()->first;
+}
+
+void SleepData::merge(SleepData&& other)
+{
+    for (auto& [idx, item] : other.sleep)
+	this->sleep.insert_or_assign(idx, std::move(item));
+    this->errors = std::move(other.errors);
 }
 
-bool SleepData::load(const rapidjson::Document& document)
+bool SleepData::includes(const SleepData& other) const
+{
+    return this->errors == other.errors && this->sleep.includes(other.sleep);
+}
+
+bool LapsData::load(const rapidjson::Value& document)
 {
     const auto data = document.FindMember("data");
     if (data == document.MemberEnd() || !data->value.IsArray())
@@ -230,257 +180,109 @@ bool SleepData::load(const rapidjson::Document& document)
 	return false;
     }
 
+    FieldDecoder<LAP_FIELDS> fields{};
     for (const auto& v : data->value.GetArray())
     {
 	if (v.IsObject())
 	{
-	    auto itr_zone_info = v.FindMember("zone_info");
-	    auto itr_assessment = v.FindMember("assessment");
-	    auto itr_levels = v.FindMember("levels");
-	    auto itr_dates = v.FindMember("dates");
-
-	    Sleep sleep_item{};
-
-	    if (itr_zone_info != v.MemberEnd() && itr_zone_info->value.IsString())
-	    {
-		sleep_item.zone_info = itr_zone_info->value.GetString();
-	    }
+	    Lap lap{};
+	    std::optional<int> start_lat{}, start_lon{}, end_lat{}, end_lon{};
 
-	    if (itr_assessment != v.MemberEnd() && itr_assessment->value.IsObject())
+	    fields.reset();
+	    for (const auto& member : v.GetObject())
 	    {
-		auto itr_cas = itr_assessment->value.FindMember("combined_awake_score");
-		auto itr_ats = itr_assessment->value.FindMember("awake_time_score");
-		auto itr_acs = itr_assessment->value.FindMember("awakenings_count_score");
-		auto itr_dss = itr_assessment->value.FindMember("deep_sleep_score");
-		auto itr_sds = itr_assessment->value.FindMember("sleep_duration_score");
-		auto itr_lss = itr_assessment->value.FindMember("light_sleep_score");
-		auto itr_oss = itr_assessment->value.FindMember("overall_sleep_score");
-		auto itr_sqs = itr_assessment->value.FindMember("sleep_quality_score");
-		auto itr_srs = itr_assessment->value.FindMember("sleep_recovery_score");
-		auto itr_rss = itr_assessment->value.FindMember("rem_sleep_score");
-		auto itr_sres = itr_assessment->value.FindMember("sleep_restlessness_score");
-		auto itr_ac = itr_assessment->value.FindMember("awakenings_count");
-		auto itr_is = itr_assessment->value.FindMember("interruptions_score");
-		auto itr_asds = itr_assessment->value.FindMember("average_stress_during_sleep");
-
-		struct SleepAssessment assessment{};
-
-		if (itr_cas != itr_assessment->value.MemberEnd() && itr_cas->value.IsInt())
-		    assessment.combined_awake_score = itr_cas->value.GetInt();
-
-		if (itr_ats != itr_assessment->value.MemberEnd() && itr_ats->value.IsInt())
-		    assessment.awake_time_score = itr_ats->value.GetInt();
-
-		if (itr_acs != itr_assessment->value.MemberEnd() && itr_acs->value.IsInt())
-		    assessment.awakenings_count_score = itr_acs->value.GetInt();
-
-		if (itr_dss != itr_assessment->value.MemberEnd() && itr_dss->value.IsInt())
-		    assessment.deep_sleep_score = itr_dss->value.GetInt();
-
-		if (itr_sds != itr_assessment->value.MemberEnd() && itr_sds->value.IsInt())
-		    assessment.sleep_duration_score = itr_sds->value.GetInt();
-
-		if (itr_lss != itr_assessment->value.MemberEnd() && itr_lss->value.IsInt())
-		    assessment.light_sleep_score = itr_lss->value.GetInt();
-
-		if (itr_oss != itr_assessment->value.MemberEnd() && itr_oss->value.IsInt())
-		    assessment.overall_sleep_score = itr_oss->value.GetInt();
-
-		if (itr_sqs != itr_assessment->value.MemberEnd() && itr_sqs->value.IsInt())
-		    assessment.sleep_quality_score = itr_sqs->value.GetInt();
-
-		if (itr_srs != itr_assessment->value.MemberEnd() && itr_srs->value.IsInt())
-		    assessment.sleep_recovery_score = itr_srs->value.GetInt();
-
-		if (itr_rss != itr_assessment->value.MemberEnd() && itr_rss->value.IsInt())
-		    assessment.rem_sleep_score = itr_rss->value.GetInt();
+		const std::string_view key{member.name.GetString(), member.name.GetStringLength()};
+		const auto hash = str_hash(key);
+		const auto& value = member.value;
+		if (fields.decode(lap, key, hash, to_scalar(value)) || !value.IsInt())
+		    continue;
 
-		if (itr_sres != itr_assessment->value.MemberEnd() && itr_sres->value.IsInt())
-		    assessment.sleep_restlessness_score = itr_sres->value.GetInt();
-
-		if (itr_ac != itr_assessment->value.MemberEnd() && itr_ac->value.IsInt())
-		    assessment.awakenings_count = itr_ac->value.GetInt();
-
-		if (itr_is != itr_assessment->value.MemberEnd() && itr_is->value.IsInt())
-		    assessment.interruptions_score = itr_is->value.GetInt();
-
-		if (itr_asds != itr_assessment->value.MemberEnd() && itr_asds->value.IsFloat())
-		    assessment.average_stress_during_sleep = itr_asds->value.GetFloat();
-
-		sleep_item.assessment = assessment;
-	    }
-
-	    if (itr_levels != v.MemberEnd() && itr_levels->value.IsArray())
-	    {
-		std::vector<SleepLevel> levels{};
-		for (const auto& l : itr_levels->value.GetArray())
+		switch (hash)
 		{
-		    if (l.IsObject())
-		    {
-			auto itr_dt_utc = l.FindMember("datetime_utc");
-			auto itr_level = l.FindMember("level");
-
-			SleepLevel level{};
-
-			if (itr_dt_utc != l.MemberEnd() && itr_dt_utc->value.IsString())
-			    level.datetime_utc = itr_dt_utc->value.GetString();
-
-			if (itr_level != l.MemberEnd() && itr_level->value.IsString())
-			    level.level = itr_level->value.GetString();
-
-			levels.emplace_back(level);
-		    }
+		case str_hash("start_position_lat"):
+		    if (key == "start_position_lat")
+			start_lat = value.GetInt();
+		    break;
+		case str_hash("start_position_long"):
+		    if (key == "start_position_long")
+			start_lon = value.GetInt();
+		    break;
+		case str_hash("end_position_lat"):
+		    if (key == "end_position_lat")
+			end_lat = value.GetInt();
+		    break;
+		case str_hash("end_position_long"):
+		    if (key == "end_position_long")
+			end_lon = value.GetInt();
+		    break;
 		}
-
-		sleep_item.levels = levels;
 	    }
 
-	    if (itr_dates != v.MemberEnd() && itr_dates->value.IsArray())
+	    if (start_lat.has_value() && start_lon.has_value() &&
+		end_lat.has_value() && end_lon.has_value())
 	    {
-		for (const auto& d : itr_dates->value.GetArray())
-		{
-		    if (d.IsString())
-		    {
-			sleep_item.dates.emplace_back(d.GetString());
-		    }
-		}
+		lap.start_lat_lon = {start_lat.value(), start_lon.value()};
+		lap.end_lat_lon = {end_lat.value(), end_lon.value()};
 	    }
 
-	    auto idx1 = sleep_item.dates.size() == 2 ? DateIdx(sleep_item.dates[0]) : DateIdx();
-	    auto idx2 = sleep_item.dates.size() == 2 ? DateIdx(sleep_item.dates[1]) : DateIdx();
-	    if (idx1.is_valid() && idx2.is_valid())
-		this->sleep[idx1] = sleep_item;
-	    else
-		this->errors.emplace_back("JSON error: dates are no valid or are not dates.");
-	}
-	else
-	{
-	    this->errors.emplace_back(
-		"JSON error: it expects an object with sleep information.");
+	    this->laps.emplace_back(lap);
 	}
     }
 
     return true;
 }
 
-bool LapsData::load(const rapidjson::Document& document)
-{
-    const auto data = document.FindMember("data");
-    if (data == document.MemberEnd() || !data->value.IsArray())
-    {
-	return false;
-    }
-
-    for (const auto& v : data->value.GetArray())
-    {
-	if (v.IsObject())
-	{
-	    Lap lap{};
-
-	    auto itr_mi = v.FindMember("message_index");
-	    auto itr_ts = v.FindMember("timestamp");
-	    auto itr_st = v.FindMember("start_time");
-	    auto itr_lat_sp = v.FindMember("start_position_lat");
-	    auto itr_lon_sp = v.FindMember("start_position_long");
-	    auto itr_lat_ep = v.FindMember("end_position_lat");
-	    auto itr_lon_ep = v.FindMember("end_position_long");
-	    auto itr_et = v.FindMember("total_elapsed_time");
-	    auto itr_tt = v.FindMember("total_timer_time");
-	    auto itr_mt = v.FindMember("total_moving_time");
-	    auto itr_td = v.FindMember("total_distance");
-	    auto itr_eavg_s = v.FindMember("enhanced_avg_speed");
-	    auto itr_avg_s = v.FindMember("avg_speed");
-	    auto itr_emax_s = v.FindMember("enhanced_max_speed");
-	    auto itr_max_s = v.FindMember("max_speed");
-	    auto itr_avg_hr = v.FindMember("avg_heart_rate");
-	    auto itr_max_hr = v.FindMember("max_heart_rate");
-	    auto itr_min_hr = v.FindMember("min_heart_rate");
-	    auto itr_avg_c = v.FindMember("avg_cadence");
-	    auto itr_max_c = v.FindMember("max_cadence");
-	    auto itr_avg_rc = v.FindMember("avg_running_cadence");
-	    auto itr_max_rc = v.FindMember("max_running_cadence");
-	    auto itr_asc = v.FindMember("total_ascent");
-	    auto itr_desc = v.FindMember("total_descent");
-	    auto itr_cal = v.FindMember("total_calories");
-
-	    if (itr_mi != v.MemberEnd() && itr_mi->value.IsInt())
-		lap.message_index = itr_mi->value.GetInt();
-
-	    if (itr_ts != v.MemberEnd() && itr_ts->value.IsString())
-		lap.timestamp = itr_ts->value.GetString();
-
-	    if (itr_st != v.MemberEnd() && itr_st->value.IsString())
-		lap.start_time = itr_st->value.GetString();
-
-	    if (itr_lat_sp != v.MemberEnd() && itr_lat_ep->value.IsInt() &&
-		itr_lon_sp != v.MemberEnd() && itr_lon_ep->value.IsInt())
-	    {
-		lap.start_lat_lon = {itr_lat_sp->value.GetInt(), itr_lon_sp->value.GetInt()};
-		lap.end_lat_lon = {itr_lat_ep->value.GetInt(), itr_lon_ep->value.GetInt()};
-	    }
-
-	    if (itr_et != v.MemberEnd() && itr_et->value.IsFloat())
-		lap.total_elapsed_time = itr_et->value.GetFloat();
-
-	    if (itr_tt != v.MemberEnd() && itr_tt->value.IsFloat())
-		lap.total_timer_time = itr_tt->value.GetFloat();
-
-	    if (itr_mt != v.MemberEnd() && itr_mt->value.IsFloat())
-		lap.total_moving_time = itr_mt->value.GetFloat();
-
-	    if (itr_td != v.MemberEnd() && itr_td->value.IsFloat())
-		lap.total_distance = itr_td->value.GetFloat();
-
-	    if (itr_eavg_s != v.MemberEnd() && itr_eavg_s->value.IsFloat())
-		lap.avg_speed = itr_eavg_s->value.GetFloat();
-	    else if (itr_avg_s != v.MemberEnd() && itr_avg_s->value.IsFloat())
-		lap.avg_speed = itr_avg_s->value.GetFloat();
-
-	    if (itr_emax_s != v.MemberEnd() && itr_emax_s->value.IsFloat())
-		lap.max_speed = itr_emax_s->value.GetFloat();
-	    else if (itr_max_s != v.MemberEnd() && itr_max_s->value.IsFloat())
-		lap.max_speed = itr_max_s->value.GetFloat();
-
-	    if (itr_emax_s != v.MemberEnd() && itr_emax_s->value.IsFloat())
-		lap.max_speed = itr_emax_s->value.GetFloat();
-	    else if (itr_max_s != v.MemberEnd() && itr_max_s->value.IsFloat())
-		lap.max_speed = itr_max_s->value.GetFloat();
-
-	    if (itr_avg_hr != v.MemberEnd() && itr_avg_hr->value.IsInt())
-		lap.avg_heart_rate = itr_avg_hr->value.GetInt();
-
-	    if (itr_max_hr != v.MemberEnd() && itr_max_hr->value.IsInt())
-		lap.max_heart_rate = itr_max_hr->value.GetInt();
-
-	    if (itr_min_hr != v.MemberEnd() && itr_min_hr->value.IsInt())
-		lap.min_heart_rate = itr_min_hr->value.GetInt();
-
-	    if (itr_avg_c != v.MemberEnd() && itr_avg_c->value.IsInt())
-		lap.avg_cadence = itr_avg_c->value.GetInt();
-
-	    if (itr_max_c != v.MemberEnd() && itr_max_c->value.IsInt())
-		lap.max_cadence = itr_max_c->value.GetInt();
-
-	    if (itr_avg_rc != v.MemberEnd() && itr_avg_rc->value.IsInt())
-		lap.avg_running_cadence = itr_avg_rc->value.GetInt();
-
-	    if (itr_max_rc != v.MemberEnd() && itr_max_rc->value.IsInt())
-		lap.max_running_cadence = itr_max_rc->value.GetInt();
-
-	    if (itr_asc != v.MemberEnd() && itr_asc->value.IsInt())
-		lap.total_ascent = itr_asc->value.GetInt();
-
-	    if (itr_desc != v.MemberEnd() && itr_desc->value.IsInt())
-		lap.total_descent = itr_desc->value.GetInt();
-
-	    if (itr_cal != v.MemberEnd() && itr_cal->value.IsInt())
-		lap.total_calories = itr_cal->value.GetInt();
-
-	    this->laps.emplace_back(lap);
-	}
-    }
-
-    return true;
+void Records::reserve(const size_t n)
+{
+    this->timestamp.reserve(n);
+    this->position_lat.reserve(n);
+    this->position_long.reserve(n);
+    this->distance.reserve(n);
+    this->speed.reserve(n);
+    this->heart_rate.reserve(n);
+    this->power.reserve(n);
+    this->cadence.reserve(n);
+    this->altitude.reserve(n);
+}
+
+void Records::clear()
+{
+    this->timestamp.clear();
+    this->position_lat.clear();
+    this->position_long.clear();
+    this->distance.clear();
+    this->speed.clear();
+    this->heart_rate.clear();
+    this->power.clear();
+    this->cadence.clear();
+    this->altitude.clear();
+}
+
+void Records::push_back(const Record& record)
+{
+    this->timestamp.push_back(record.timestamp);
+    this->position_lat.push_back(record.position_lat_lon.first);
+    this->position_long.push_back(record.position_lat_lon.second);
+    this->distance.push_back(record.distance);
+    this->speed.push_back(record.speed);
+    this->heart_rate.push_back(record.heart_rate);
+    this->power.push_back(record.power);
+    this->cadence.push_back(record.cadence);
+    this->altitude.push_back(record.altitude);
+}
+
+Record Records::operator[](const size_t i) const
+{
+    return {
+	.timestamp = this->timestamp[i],
+	.position_lat_lon = {this->position_lat[i], this->position_long[i]},
+	.distance = this->distance[i],
+	.speed = this->speed[i],
+	.heart_rate = this->heart_rate[i],
+	.power = this->power[i],
+	.cadence = this->cadence[i],
+	.altitude = this->altitude[i]
+    };
 }
 
 std::ostream& operator<<(std::ostream& os, ActivityType at)
@@ -496,400 +298,21 @@ std::ostream& operator<<(std::ostream& os, ActivityType at)
     return os;
 }
 
-ActivityType Activity::get_id() const
+DateIdx ActivitiesData::newest() const
 {
-    return ActivityType::GENERIC;
+    return this->activities.empty() ? DateIdx() : this->activities.rbegin()->first;
 }
 
-ActivityType SetsActivity::get_id() const
+void ActivitiesData::merge(ActivitiesData&& other)
 {
-    return ActivityType::SETS;
+    for (auto& [idx, item] : other.activities)
+	this->activities.insert_or_assign(idx, std::move(item));
+    this->errors = std::move(other.errors);
 }
 
-ActivityType SplitsActivity::get_id() const
+bool ActivitiesData::includes(const ActivitiesData& other) const
 {
-    return ActivityType::SPLITS;
-}
-
-ActivityType DistanceActivity::get_id() const
-{
-    return ActivityType::DISTANCE;
-}
-
-ActivitiesData::ActivitiesData(const ActivitiesData& other)
-{
-    activities.clear();
-    for (const auto& [idx, a] : other.activities)
-    {
-	switch (a->get_id())
-	{
-	case ActivityType::DISTANCE:
-	    activities[idx] = std::make_unique<DistanceActivity>(dynamic_cast<DistanceActivity&>(*a));
-	    break;
-	case ActivityType::SETS:
-	    activities[idx] = std::make_unique<SetsActivity>(dynamic_cast<SetsActivity&>(*a));
-	    break;
-	case ActivityType::SPLITS:
-	    activities[idx] = std::make_unique<SplitsActivity>(dynamic_cast<SplitsActivity&>(*a));
-	    break;
-	default:
-	    activities[idx] = std::make_unique<Activity>(*a);
-	    break;
-	}
-    }
-
-    errors = other.errors;
-}
-
-ActivitiesData& ActivitiesData::operator=(const ActivitiesData& other)
-{
-    if (this != &other)
-    {
-	activities.clear();
-
-	for (const auto& [idx, a] : other.activities)
-	{
-	    switch (a->get_id())
-	    {
-	    case ActivityType::DISTANCE:
-		activities[idx] = std::make_unique<DistanceActivity>(dynamic_cast<DistanceActivity&>(*a));
-		break;
-	    case ActivityType::SETS:
-		activities[idx] = std::make_unique<SetsActivity>(dynamic_cast<SetsActivity&>(*a));
-		break;
-	    case ActivityType::SPLITS:
-		activities[idx] = std::make_unique<SplitsActivity>(dynamic_cast<SplitsActivity&>(*a));
-		break;
-	    default:
-		activities[idx] = std::make_unique<Activity>(*a);
-		break;
-	    }
-	}
-
-	errors = other.errors;
-    }
-    return *this;
-}
-
-bool ActivitiesData::load(const rapidjson::Document& document)
-{
-    const auto data = document.FindMember("data");
-    if (data == document.MemberEnd() || !data->value.IsArray())
-    {
-	return false;
-    }
-
-    for (const auto& v : data->value.GetArray())
-    {
-	if (v.IsObject())
-	{
-	    std::unique_ptr<Activity> activity;
-
-	    auto itr_id = v.FindMember("id");
-	    auto itr_zone_info = v.FindMember("zone_info");
-	    auto itr_username = v.FindMember("username");
-	    auto itr_session = v.FindMember("session");
-	    auto itr_splits = v.FindMember("splits");
-	    auto itr_sets = v.FindMember("sets");
-	    if (itr_splits != v.MemberEnd() && itr_splits->value.IsArray())
-	    {
-		float total_work_time = 0;
-		activity = std::make_unique<SplitsActivity>();
-		for (const auto& s : itr_splits->value.GetArray())
-		{
-		    if (s.IsObject())
-		    {
-			Split split{};
-
-			auto itr_st = s.FindMember("split_type");
-			auto itr_tet = s.FindMember("total_elapsed_time");
-			auto itr_ttt = s.FindMember("total_timer_time");
-			auto itr_sti = s.FindMember("start_time");
-			auto itr_ah = s.FindMember("avg_hr");
-			auto itr_mh = s.FindMember("max_hr");
-			auto itr_tc = s.FindMember("total_calories");
-			auto itr_d = s.FindMember("difficulty");
-			auto itr_r = s.FindMember("result");
-			auto itr_di = s.FindMember("discarded");
-
-			if (itr_st != s.MemberEnd() && itr_st->value.IsString())
-			    split.split_type = itr_st->value.GetString();
-			if (itr_tet != s.MemberEnd() && itr_tet->value.IsFloat())
-			    split.total_elapsed_time = itr_tet->value.GetFloat();
-			if (itr_sti != s.MemberEnd() && itr_sti->value.IsFloat())
-			    split.start_time = itr_sti->value.GetFloat();
-			if (itr_ah != s.MemberEnd() && itr_ah ->value.IsInt())
-			    split.avg_hr = itr_ah->value.GetInt();
-			if (itr_mh != s.MemberEnd() && itr_mh ->value.IsInt())
-			    split.max_hr = itr_mh->value.GetInt();
-			if (itr_tc != s.MemberEnd() && itr_tc->value.IsInt())
-			    split.total_calories = itr_tc->value.GetInt();
-			if (itr_d != s.MemberEnd() && itr_d->value.IsInt())
-			    split.difficulty = itr_d->value.GetInt();
-			if (itr_di != s.MemberEnd() && itr_di->value.IsInt())
-			    split.result = SplitResult::DISCARDED;
-			if (itr_r != s.MemberEnd() && itr_r->value.IsInt())
-			{
-			    if (itr_r->value.GetInt() == 2)
-				split.result = SplitResult::ATTEMPTED;
-			    else if (itr_r->value.GetInt() == 3)
-				split.result = SplitResult::COMPLETED;
-			}
-			if (itr_ttt != s.MemberEnd() && itr_ttt->value.IsFloat())
-			{
-			    split.total_timer_time = itr_ttt->value.GetFloat();
-			    if (split.result == SplitResult::ATTEMPTED || split.result == SplitResult::COMPLETED)
-				total_work_time += split.total_timer_time;
-			}
-
-			(static_cast<SplitsActivity*>(activity.get()))->splits.emplace_back(split);
-		    }
-		}
-		if (total_work_time > 0)
-		    activity->total_work_time = total_work_time;
-	    }
-	    else if (itr_sets != v.MemberEnd() && itr_sets->value.IsArray())
-	    {
-		float total_work_time = 0;
-		activity = std::make_unique<SetsActivity>();
-		for (const auto& s : itr_sets->value.GetArray())
-		{
-		    if (s.IsObject())
-		    {
-			Set set{};
-
-			auto itr_t = s.FindMember("timestamp");
-			auto itr_st = s.FindMember("set_type");
-			auto itr_d = s.FindMember("duration");
-			auto itr_r = s.FindMember("repetitions");
-			auto itr_w = s.FindMember("weight");
-			auto itr_sti = s.FindMember("start_time");
-			auto itr_c = s.FindMember("category");
-			auto itr_sc = s.FindMember("category_subtype");
-			auto itr_wdu = s.FindMember("weight_display_unit");
-			auto itr_mi = s.FindMember("message_index");
-			auto itr_wsi = s.FindMember("wkt_step_index");
-
-			if (itr_t != s.MemberEnd() && itr_t->value.IsString())
-			    set.timestamp = itr_t->value.GetString();
-			if (itr_st != s.MemberEnd() && itr_st->value.IsString())
-			{
-			    auto it = std::find(std::begin(set_type_names), std::end(set_type_names), itr_st->value.GetString());
-			    if (it != std::end(set_type_names))
-			    {
-				std::size_t idx = std::distance(std::begin(set_type_names), it);
-				set.set_type = SetType(idx);
-			    }
-			}
-			if (itr_d != s.MemberEnd() && itr_d->value.IsFloat())
-			{
-			    set.duration = itr_d->value.GetFloat();
-			    if (set.set_type == SetType::ACTIVE)
-				total_work_time += set.duration;
-			}
-			if (itr_r != s.MemberEnd() && itr_r->value.IsInt())
-			    set.repetitions = itr_r->value.GetInt();
-			if (itr_w != s.MemberEnd() && itr_w->value.IsFloat())
-			    set.weight = itr_w->value.GetFloat();
-			if (itr_sti != s.MemberEnd() && itr_sti->value.IsString())
-			    set.start_time = itr_sti->value.GetString();
-			if (itr_c != s.MemberEnd() && itr_c->value.IsArray())
-			{
-			    for (const auto& v : itr_c->value.GetArray())
-			    {
-				if (v.IsInt())
-				    set.category.emplace_back(std::to_string(v.GetInt()));
-				else if (v.IsString())
-				    set.category.emplace_back(v.GetString());
-			    }
-			}
-			if (itr_sc != s.MemberEnd() && itr_sc->value.IsArray())
-			{
-			    for (const auto& v : itr_sc->value.GetArray())
-			    {
-				if (v.IsInt())
-				    set.category_subtype.emplace_back(std::to_string(v.GetInt()));
-				else if (v.IsString())
-				    set.category_subtype.emplace_back(v.GetString());
-			    }
-			}
-			if (itr_wdu != s.MemberEnd() && itr_wdu->value.IsString())
-			    set.weight_display_unit = itr_wdu->value.GetString();
-			if (itr_mi != s.MemberEnd() && itr_mi->value.IsInt())
-			    set.message_index = itr_mi->value.GetInt();
-			if (itr_wsi != s.MemberEnd() && itr_wsi->value.IsInt())
-			    set.wkt_step_index = itr_wsi->value.GetInt();
-
-			(static_cast<SetsActivity*>(activity.get()))->sets.emplace_back(set);
-		    }
-		}
-		if (total_work_time > 0)
-		    activity->total_work_time = total_work_time;
-	    }
-	    else
-	    {
-		activity = std::make_unique<DistanceActivity>();
-	    }
-
-	    if (itr_id != v.MemberEnd() && itr_id->value.IsString())
-	    {
-		activity->id = itr_id->value.GetString();
-	    }
-
-	    if (itr_zone_info != v.MemberEnd() && itr_zone_info->value.IsString())
-	    {
-		activity->zone_info = itr_zone_info->value.GetString();
-	    }
-
-	    if (itr_username != v.MemberEnd() && itr_username->value.IsString())
-	    {
-		activity->username = itr_username->value.GetString();
-	    }
-
-	    if (itr_session != v.MemberEnd() && itr_session->value.IsObject())
-	    {
-		auto itr_spn = itr_session->value.FindMember("sport_profile_name");
-		auto itr_s = itr_session->value.FindMember("sport");
-		auto itr_ss = itr_session->value.FindMember("sub_sport");
-		auto itr_splat = itr_session->value.FindMember("start_position_lat");
-		auto itr_splon = itr_session->value.FindMember("start_position_lon");
-		auto itr_eplat = itr_session->value.FindMember("end_position_lat");
-		auto itr_eplon = itr_session->value.FindMember("end_position_lon");
-		auto itr_st = itr_session->value.FindMember("start_time");
-		auto itr_et = itr_session->value.FindMember("total_elapsed_time");
-		auto itr_tt = itr_session->value.FindMember("total_timer_time");
-		auto itr_td = itr_session->value.FindMember("total_distance");
-		auto itr_eas = itr_session->value.FindMember("enhanced_avg_speed");
-		auto itr_as = itr_session->value.FindMember("avg_speed");
-		auto itr_ems = itr_session->value.FindMember("enhanced_max_speed");
-		auto itr_ms = itr_session->value.FindMember("max_speed");
-		auto itr_ac = itr_session->value.FindMember("avg_cadence");
-		auto itr_mc = itr_session->value.FindMember("max_cadence");
-		auto itr_arc = itr_session->value.FindMember("avg_running_cadence");
-		auto itr_mrc = itr_session->value.FindMember("max_running_cadence");
-		auto itr_ts = itr_session->value.FindMember("total_strides");
-		auto itr_tc = itr_session->value.FindMember("total_calories");
-		auto itr_ta = itr_session->value.FindMember("total_ascent");
-		auto itr_tde = itr_session->value.FindMember("total_descent");
-		auto itr_at = itr_session->value.FindMember("avg_temperature");
-		auto itr_mat = itr_session->value.FindMember("max_temperature");
-		auto itr_mit = itr_session->value.FindMember("min_temperature");
-		auto itr_earr = itr_session->value.FindMember("enhanced_avg_respiration_rate");
-		auto itr_emaxrr = itr_session->value.FindMember("enhanced_max_respiration_rate");
-		auto itr_eminrr = itr_session->value.FindMember("enhanced_min_respiration_rate");
-		auto itr_tlp = itr_session->value.FindMember("training_load_peak");
-		auto itr_tte = itr_session->value.FindMember("total_training_effect");
-		auto itr_tate = itr_session->value.FindMember("total_anaerobic_training_effect");
-
-		if (itr_spn != itr_session->value.MemberEnd() && itr_spn->value.IsString())
-		    activity->sport_profile_name = itr_spn->value.GetString();
-
-		if (itr_s != itr_session->value.MemberEnd() && itr_s->value.IsString())
-		    activity->sport = itr_s->value.GetString();
-
-		if (itr_ss != itr_session->value.MemberEnd() && itr_ss->value.IsString())
-		    activity->sub_sport = itr_ss->value.GetString();
-
-		if (itr_splat != itr_session->value.MemberEnd() && itr_splat->value.IsNumber() &&
-		    itr_splon != itr_session->value.MemberEnd() && itr_splon->value.IsNumber())
-		    activity->start_lat_lon = {itr_splat->value.GetFloat(), itr_splon->value.GetFloat()};
-
-		if (itr_eplat != itr_session->value.MemberEnd() && itr_eplat->value.IsNumber() &&
-		    itr_eplon != itr_session->value.MemberEnd() && itr_eplon->value.IsNumber())
-		    activity->end_lat_lon = {itr_eplat->value.GetFloat(), itr_eplon->value.GetFloat()};
-
-		if (itr_st != itr_session->value.MemberEnd() && itr_st->value.IsString())
-		    activity->start_time_utc = itr_st->value.GetString();
-
-		if (itr_et != itr_session->value.MemberEnd() && itr_et->value.IsNumber())
-		    activity->total_elapsed_time = itr_et->value.GetFloat();
-
-		if (itr_tt != itr_session->value.MemberEnd() && itr_tt->value.IsNumber())
-		{
-		    activity->total_timer_time = itr_tt->value.GetFloat();
-		    if (!activity->total_work_time.has_value())
-			activity->total_work_time = activity->total_timer_time;
-		}
-
-		if (itr_td != itr_session->value.MemberEnd() && itr_td->value.IsNumber())
-		    activity->total_distance =itr_td->value.GetFloat();
-
-		if (itr_eas != itr_session->value.MemberEnd() && itr_eas->value.IsNumber())
-		    activity->avg_speed = itr_eas->value.GetFloat();
-		else if (itr_as != itr_session->value.MemberEnd() && itr_as->value.IsNumber())
-		    activity->avg_speed = itr_as->value.GetFloat();
-
-		if (itr_ems != itr_session->value.MemberEnd() && itr_ems->value.IsNumber())
-		    activity->max_speed = itr_ems->value.GetFloat();
-		else if (itr_ms != itr_session->value.MemberEnd() && itr_ms->value.IsNumber())
-		    activity->max_speed = itr_ms->value.GetFloat();
-
-		if (itr_ac != itr_session->value.MemberEnd() && itr_ac->value.IsNumber())
-		    activity->avg_cadence = itr_ac->value.GetFloat();
-
-		if (itr_mc != itr_session->value.MemberEnd() && itr_mc->value.IsNumber())
-		    activity->max_cadence = itr_mc->value.GetFloat();
-
-		if (itr_arc != itr_session->value.MemberEnd() && itr_arc->value.IsNumber())
-		    activity->avg_running_cadence = itr_arc->value.GetFloat();
-
-		if (itr_mrc != itr_session->value.MemberEnd() && itr_mrc->value.IsNumber())
-		    activity->max_running_cadence = itr_mrc->value.GetFloat();
-
-		if (itr_ts != itr_session->value.MemberEnd() && itr_ts->value.IsNumber())
-		    activity->total_strides = itr_ts->value.GetFloat();
-
-		if (itr_tc != itr_session->value.MemberEnd() && itr_tc->value.IsNumber())
-		    activity->total_calories = itr_tc->value.GetFloat();
-
-		if (itr_ta != itr_session->value.MemberEnd() && itr_ta->value.IsNumber())
-		    activity->total_ascent = itr_ta->value.GetFloat();
-
-		if (itr_tde != itr_session->value.MemberEnd() && itr_tde->value.IsNumber())
-		    activity->total_descent = itr_tde->value.GetFloat();
-
-		if (itr_at != itr_session->value.MemberEnd() && itr_at->value.IsNumber())
-		    activity->avg_temperature = itr_at->value.GetFloat();
-
-		if (itr_mat != itr_session->value.MemberEnd() && itr_mat->value.IsNumber())
-		    activity->max_temperature = itr_mat->value.GetFloat();
-
-		if (itr_mit != itr_session->value.MemberEnd() && itr_mit->value.IsNumber())
-		    activity->min_temperature = itr_mit->value.GetFloat();
-
-		if (itr_earr != itr_session->value.MemberEnd() && itr_earr->value.IsNumber())
-		    activity->avg_respiration_rate = itr_earr->value.GetFloat();
-
-		if (itr_emaxrr != itr_session->value.MemberEnd() && itr_emaxrr->value.IsNumber())
-		    activity->max_respiration_rate = itr_emaxrr->value.GetFloat();
-
-		if (itr_eminrr != itr_session->value.MemberEnd() && itr_eminrr->value.IsNumber())
-		    activity->min_respiration_rate = itr_eminrr->value.GetFloat();
-
-		if (itr_tlp != itr_session->value.MemberEnd() && itr_tlp->value.IsNumber())
-		    activity->training_load_peak = itr_tlp->value.GetFloat();
-
-		if (itr_tte != itr_session->value.MemberEnd() && itr_tte->value.IsNumber())
-		    activity->total_training_effect = itr_tte->value.GetFloat();
-
-		if (itr_tate != itr_session->value.MemberEnd() && itr_tate->value.IsNumber())
-		    activity->total_anaerobic_training_effect = itr_tate->value.GetFloat();
-	    }
-
-	    DateIdx idx{activity->start_time_utc};
-	    if (!activity->start_time_utc.empty() && idx.is_valid())
-		this->activities[idx] = std::move(activity);
-	    else
-		this->errors.emplace_back("JSON error: start time is not a valid date.");
-	}
-	else
-	{
-	    this->errors.emplace_back(
-		"JSON error: it expects an object with activity information.");
-	}
-    }
-
-    return true;
+    return this->errors == other.errors && this->activities.includes(other.activities);
 }
 
 bool Error::has_error() const
@@ -935,60 +358,12 @@ std::string Error::error_to_string() const
 }
 
 template <typename T>
-Result<T>::Result()
-{
-    error = Error();
-    status = {};
-    data = std::unique_ptr<T>();
-}
-
-template <typename T>
-Result<T>::Result(const Result<T>& other)
-{
-    error = other.error;
-    status = other.status;
-    data = std::make_unique<T>(*other.data);
-}
-
-template <typename T>
-Result<T>::Result(Result<T>&& other) noexcept
-{
-    error = std::move(other.error);
-    status = other.status;
-    data = std::move(other.data);
-}
-
-template <typename T>
-Result<T>& Result<T>::operator=(const Result<T>& other)
-{
-    if (this != &other)
-    {
-	error = other.error;
-	status = other.status;
-	data = other.data ? std::make_unique<T>(*other.data) : std::make_unique<T>();
-    }
-    return *this;
-}
-
-template <typename T>
-Result<T>& Result<T>::operator=(const Result<T>&& other) noexcept
-{
-    if (this != &other)
-    {
-	error = other.error;
-	status = other.status;
-	data = other.data ? std::make_unique<T>(*other.data) : std::make_unique<T>();
-    }
-    return *this;
-}
-
-template <typename T>
-void Result<T>::load(const httplib::Result &response)
+bool Result<T>::load_status(const httplib::Result &response)
 {
     if (!response)
     {
     	this->error = Error(ErrorType::NotResponse);
-    	return;
+    	return false;
     }
 
     this->status = response->status;
@@ -996,37 +371,53 @@ void Result<T>::load(const httplib::Result &response)
     if (response->status < 200)
     {
     	this->error = Error(ErrorType::Http100, response.error());
-    	return;
+    	return false;
     }
 
     if (response->status >= 300 && response->status < 400)
     {
     	this->error = Error(ErrorType::Http300, response.error());
-    	return;
+    	return false;
     }
 
     if (response->status == 401)
     {
     	this->error = Error(ErrorType::Http401, response.error());
-    	return;
+    	return false;
     }
 
     if (response->status > 401 && response->status < 500)
     {
     	this->error = Error(ErrorType::Http400, response.error());
-    	return;
+    	return false;
     }
 
     if (response->status >= 500)
     {
     	this->error = Error(ErrorType::Http500, response.error());
-    	return;
+    	return false;
     }
 
-    rapidjson::Document document;
-    document.Parse(response->body.c_str());
-    this->data = std::make_unique<T>();
-    bool is_valid = this->data->load(document);
+    return true;
+}
+
+/**
+ * Data is loaded from a DOM parsed in the arena, in the body of the response.
+ * Datasets are not loaded from a DOM but from their SAX parsers (see sax.h).
+ */
+template <typename T>
+void Result<T>::load(httplib::Result &response, JsonArena& arena)
+{
+    if (!this->load_status(response))
+	return;
+
+    auto parsed = std::make_shared<T>();
+    bool is_valid;
+    if constexpr (std::is_base_of_v<Data, T>)
+	is_valid = parsed->load(arena.parse(response->body));
+    else
+	is_valid = parse_json(response->body, *parsed);
+    this->data = std::move(parsed);
 
     if (is_valid)
         this->error = Error(ErrorType::Success, response.error());
@@ -1034,62 +425,273 @@ void Result<T>::load(const httplib::Result &response)
         this->error = Error(ErrorType::NotData, response.error());
 }
 
+/**
+ * Like load(response) but the body has already been parsed into parsedData
+ * while it was received.
+ */
+template <typename T>
+void Result<T>::load(const httplib::Result &response, T&& parsedData, const bool is_parsed)
+{
+    if (!this->load_status(response))
+	return;
+
+    this->data = std::make_shared<const T>(std::move(parsedData));
+
+    if (is_parsed)
+        this->error = Error(ErrorType::Success, response.error());
+    else
+        this->error = Error(ErrorType::NotData, response.error());
+}
+
+template <typename T>
+void Result<T>::load(const T& newData, const Error& newError)
+{
+    this->data = std::make_shared<const T>(newData);
+    this->error = newError;
+}
+
+template <typename T>
+void Result<T>::load(std::shared_ptr<const T> snapshot, const Error& newError)
+{
+    this->data = std::move(snapshot);
+    this->error = newError;
+}
+
+ClientPool::Item ClientPool::make_item() const
+{
+    auto client = std::make_unique<httplib::Client>(this->host);
+    if (!this->token.empty())
+	client->set_bearer_token_auth(this->token);
+    client->set_keep_alive(true);
+    client->set_decompress(true);
+    client->set_connection_timeout(CONNECTION_TIMEOUT_SECONDS, 0);
+    client->set_read_timeout(READ_TIMEOUT_SECONDS, 0);
+    client->set_write_timeout(WRITE_TIMEOUT_SECONDS, 0);
+    return {std::move(client), std::make_unique<JsonArena>()};
+}
+
+void ClientPool::release(Item item)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->idle.size() < CLIENT_POOL_MAX_IDLE)
+	this->idle.emplace_back(std::move(item));
+}
+
+ClientPool::Lease ClientPool::acquire()
+{
+    {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	if (!this->idle.empty())
+	{
+	    auto item = std::move(this->idle.back());
+	    this->idle.pop_back();
+	    return Lease(this->shared_from_this(), std::move(item));
+	}
+    }
+
+    return Lease(this->shared_from_this(), this->make_item());
+}
+
+ClientPool::Lease::~Lease()
+{
+    if (this->item.client)
+	this->pool->release(std::move(this->item));
+}
+
+Connection::Connection(const std::string& host)
+    : host{host},
+      token{},
+      username{},
+      offline{false},
+      streaming{DATASETS_STREAMING},
+      pool{std::make_shared<ClientPool>(host, "")},
+      laps_cache{std::make_shared<LapsCache>(cache_dir() / "laps")}
+{
+    this->reset_datasets_caches();
+}
+
+/**
+ * It creates new datasets caches and, if there is an user, it loads them from
+ * the user's snapshots.
+ */
+void Connection::reset_datasets_caches()
+{
+    this->steps_cache = std::make_shared<DatasetCache<StepsData>>();
+    this->sleep_cache = std::make_shared<DatasetCache<SleepData>>();
+    this->activities_cache = std::make_shared<DatasetCache<ActivitiesData>>();
+
+    if (!is_safe_file_name(this->username))
+	return;
+
+    const auto dir = cache_dir() / "snapshots" / this->username;
+    this->steps_cache->snapshot = dir / "steps.bin";
+    this->sleep_cache->snapshot = dir / "sleep.bin";
+    this->activities_cache->snapshot = dir / "activities.bin";
+
+    this->load_snapshot(*this->steps_cache);
+    this->load_snapshot(*this->sleep_cache);
+    this->load_snapshot(*this->activities_cache);
+}
+
+template <typename T>
+void Connection::load_snapshot(DatasetCache<T>& cache) const
+{
+    const auto content = read_file(cache.snapshot);
+    if (!content.has_value())
+	return;
+
+    BinaryReader reader{content.value()};
+    std::string etag{};
+    std::string last_modified{};
+    auto data = std::make_shared<T>();
+    reader.read(etag);
+    reader.read(last_modified);
+    if (!deserialize(reader, *data) || !reader.at_end())
+	return;
+
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    cache.etag = std::move(etag);
+    cache.last_modified = std::move(last_modified);
+    cache.data = std::move(data);
+}
+
+/**
+ * The data is serialized and written in another thread: it is an immutable
+ * snapshot, so it does not need the lock of the cache.
+ *
+ * Saves take their data in order (saving_mutex) and every save waits for the
+ * previous one before writing, so an older snapshot never overwrites a newer
+ * one. The caller does not wait for any of them.
+ */
 template <typename T>
-void Result<T>::load(const T& newData)
+void Connection::save_snapshot(DatasetCache<T>& cache) const
 {
-    this->data = std::make_unique<T>(newData);
+    std::lock_guard<std::mutex> saving_lock(cache.saving_mutex);
+    std::string etag{};
+    std::string last_modified{};
+    std::shared_ptr<const T> data{};
+    {
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	if (cache.snapshot.empty() || !cache.data)
+	    return;
+	etag = cache.etag;
+	last_modified = cache.last_modified;
+	data = cache.data;
+    }
+
+    cache.saving = std::async(
+	std::launch::async,
+	[previous = std::move(cache.saving), path = cache.snapshot, etag = std::move(etag),
+	 last_modified = std::move(last_modified), data = std::move(data)]() {
+	    if (previous.valid())
+		previous.wait();
+
+	    BinaryWriter writer{};
+	    writer.write(etag);
+	    writer.write(last_modified);
+	    serialize(writer, *data);
+	    write_file(path, writer.data());
+	});
 }
 
 const Result<LoginData> Connection::login(const std::string& username, const std::string& password)
 {
-    //httplib::Client client(this->host, this->port);
-    httplib::Client client(HOST);
-    //httplib::SSLClient client("fitapi.rgmf.es");
+    auto client = this->pool->acquire();
     std::stringstream credentials;
-    rapidjson::Document document;
 
     credentials << "username=" << username << "&password=" << password;
-    auto response = client.Post("/auth/login/", credentials.str(), "application/x-www-form-urlencoded");
-
-    //httplib::Params credentials;
-    //credentials.emplace("username", username.c_str());
-    //credentials.emplace("password", password.c_str());
-
-    //auto response = client.Post("/auth/login", credentials);
+    client->set_connection_timeout(LOGIN_CONNECTION_TIMEOUT_SECONDS, 0);
+    auto response = client->Post("/auth/login/", credentials.str(), "application/x-www-form-urlencoded");
+    client->set_connection_timeout(CONNECTION_TIMEOUT_SECONDS, 0);
 
     Result<LoginData> result{};
-    result.load(response);
+    result.load(response, client.arena());
 
     if (result.is_valid())
+    {
         this->token = result.get_data().access_token;
+	this->username = username;
+	this->offline = false;
+	this->pool = std::make_shared<ClientPool>(this->host, this->token);
+	this->reset_datasets_caches();
+    }
 
     return result;
 }
 
-void Connection::logout() { this->token = ""; }
+void Connection::logout()
+{
+    this->token = "";
+    this->username = "";
+    this->offline = false;
+    this->pool = std::make_shared<ClientPool>(this->host, this->token);
+    this->reset_datasets_caches();
+}
 
 bool Connection::has_token() const { return !this->token.empty(); }
 
+/**
+ * It opens the snapshots of the user without login, so datasets are served
+ * from them. It returns false if there are not snapshots for the user.
+ */
+bool Connection::open_offline(const std::string& username)
+{
+    this->token = "";
+    this->username = username;
+    this->reset_datasets_caches();
+    this->offline = this->steps_cache->data || this->sleep_cache->data || this->activities_cache->data;
+    if (!this->offline)
+    {
+	this->username = "";
+	this->reset_datasets_caches();
+    }
+
+    return this->offline;
+}
+
+bool Connection::is_offline() const { return this->offline; }
+
+void Connection::set_streaming(const bool streaming) { this->streaming = streaming; }
+
 const Result<UploadedFileData> Connection::do_post_for_file(
-    httplib::Client& client, const std::filesystem::path& path) const
+    ClientPool::Lease& client, const std::filesystem::path& path) const
 {
     try
     {
-        // Open and read the file in a buffer.
-        std::ifstream file(path.string(), std::ios::binary);
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        file.close();
+        // Open the file: it is read in chunks of UPLOAD_CHUNK_SIZE bytes while
+        // the request is written to the socket, so it is never fully in memory.
+        auto file = std::make_shared<std::ifstream>(path, std::ios::binary);
+        if (!file->is_open())
+            throw std::runtime_error("File cannot be opened: " + path.string());
 
         // Send POST request with the file.
         httplib::MultipartFormDataItems items = {
-            { "files", buffer.str(), path.filename().string(), "application/octet-stream" },
             { "zone", "Europe/Madrid", "", "" }
         };
+        httplib::MultipartFormDataProviderItems provider_items = {
+            {
+                "files",
+                [file, buffer = std::vector<char>(UPLOAD_CHUNK_SIZE)](
+                    size_t, httplib::DataSink& sink) mutable
+                {
+                    file->read(buffer.data(), buffer.size());
+                    const auto n = file->gcount();
+                    if (n > 0 && !sink.write(buffer.data(), n))
+                        return false;
+                    if (file->eof())
+                        sink.done();
+                    return !file->bad();
+                },
+                path.filename().string(),
+                "application/octet-stream"
+            }
+        };
 
-        auto response = client.Post("/files/", items);
+        client->set_compress(UPLOAD_COMPRESSION);
+        auto response = client->Post("/files/", httplib::Headers{}, items, provider_items);
+        client->set_compress(false);
         Result<UploadedFileData> result;
-        result.load(response);
+        result.load(response, client.arena());
         return result;
     }
     catch (const std::exception& e)
@@ -1108,87 +710,276 @@ const Result<UploadedFileData> Connection::do_post_for_file(
     }
 }
 
-const std::vector<Result<UploadedFileData>> Connection::post_file(std::filesystem::path& path) const
+/**
+ * It uploads the file or all the files inside the directory.
+ *
+ * Files are sent by, at most, in_flight workers, each one with a client
+ * borrowed from the pool, so several requests are in flight at the same time.
+ * Results keep the directory order.
+ */
+const std::vector<Result<UploadedFileData>> Connection::post_file(
+    std::filesystem::path& path, const size_t in_flight) const
 {
-    std::vector<Result<UploadedFileData>> results;
-
-    httplib::Client client(HOST);
-    client.set_bearer_token_auth(this->token);
-    client.set_connection_timeout(CONNECTION_TIMEOUT_SECONDS, 0);
-    client.set_read_timeout(READ_TIMEOUT_SECONDS, 0);
-    client.set_write_timeout(WRITE_TIMEOUT_SECONDS, 0);
+    std::vector<std::filesystem::path> paths;
 
     if (std::filesystem::is_regular_file(path))
     {
-        auto result = this->do_post_for_file(client, path);
-        results.emplace_back(std::move(result));
+        paths.emplace_back(path);
     }
     else if (std::filesystem::is_directory(path))
     {
         for (const auto& e : std::filesystem::directory_iterator(path))
-        {
-            auto p = e.path();
-            auto result = this->do_post_for_file(client, p);
-            results.emplace_back(std::move(result));
-        }
+            paths.emplace_back(e.path());
     }
 
+    std::vector<Result<UploadedFileData>> results(paths.size());
+    parallel_for(paths.size(), in_flight, [this, &paths, &results](const size_t i) {
+	auto client = this->pool->acquire();
+	results[i] = this->do_post_for_file(client, paths[i]);
+    });
+
     return results;
 }
 
-const Result<StepsData> Connection::get_steps() const
+/**
+ * GET request whose body is parsed while it is received: the chunks are given
+ * to the SAX parser of the dataset, that runs in its own thread, so parsing
+ * overlaps with the transfer.
+ *
+ * Only the body of successful responses is parsed and it is not kept in the
+ * response.
+ */
+template <typename T>
+httplib::Result get_parsing(
+    httplib::Client& client, const std::string& endpoint, const httplib::Params& params,
+    const httplib::Headers& headers, T& data, bool& is_parsed)
+{
+    ChunkStream stream;
+    std::thread parser([&stream, &data, &is_parsed]() {
+	is_parsed = parse_json(stream, data);
+    });
+
+    // The parser has to end even if the request throws.
+    struct ParserJoin
+    {
+	ChunkStream& stream;
+	std::thread& parser;
+	~ParserJoin() { stream.close(); parser.join(); }
+    } parser_join{stream, parser};
+
+    bool is_success = false;
+    return client.Get(
+	endpoint, params, headers,
+	[&is_success](const httplib::Response& response) {
+	    is_success = response.status >= 200 && response.status < 300;
+	    return true;
+	},
+	[&is_success, &stream](const char* data, size_t data_length) {
+	    if (is_success)
+		stream.push(data, data_length);
+	    return true;
+	});
+}
+
+/**
+ * It gets the dataset from the endpoint with a conditional request.
+ *
+ * If there is a previous response in the cache, its validators are sent and a
+ * 304 Not Modified response reuses the cached data. Otherwise, the response is
+ * parsed and, if it is valid, it replaces the cache.
+ *
+ * When the cache has data, only the records since the newest one are requested
+ * and they are merged into a copy of the cache, which replaces it. The newest
+ * record is requested again because it could have changed (i.e. steps of today).
+ * If the records are already in the cache, it is kept as it is and it is not
+ * saved again.
+ *
+ * Offline, or if there is not response, the cached data is returned. Results
+ * share the snapshot of the cache, they do not copy it.
+ */
+template <typename T>
+const Result<T> Connection::get_dataset(const std::string& endpoint, DatasetCache<T>& cache) const
 {
-    httplib::Client client(HOST);
-    client.set_bearer_token_auth(this->token);
-    client.set_connection_timeout(CONNECTION_TIMEOUT_SECONDS, 0);
-    client.set_read_timeout(READ_TIMEOUT_SECONDS, 0);
-    client.set_write_timeout(WRITE_TIMEOUT_SECONDS, 0);
-    auto response = client.Get("/monitorings/steps/");
-
-    Result<StepsData> result;
-    result.load(response);
+    Result<T> result;
+
+    if (this->offline)
+    {
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	if (cache.data)
+	    result.load(cache.data, Error(ErrorType::Success));
+	else
+	    result.load(T(), Error(ErrorType::NotResponse));
+	return result;
+    }
+
+    httplib::Params params{};
+    httplib::Headers headers{};
+    {
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	if (cache.data)
+	{
+	    const auto newest = cache.data->newest();
+	    if (newest.is_valid())
+		params.emplace("since", newest.value());
+	    if (!cache.etag.empty())
+		headers.emplace("If-None-Match", cache.etag);
+	    if (!cache.last_modified.empty())
+		headers.emplace("If-Modified-Since", cache.last_modified);
+	}
+    }
+
+    // A full download (without since) is the whole history: if the dataset has
+    // a parallel parser, the body is buffered to parse it in several threads
+    // instead of in one thread while it is received.
+    const bool streaming = this->streaming && !(HAS_PARALLEL_PARSE<T> && params.empty());
+    T parsed{};
+    bool is_parsed = false;
+    auto client = this->pool->acquire();
+    auto response = streaming
+	? get_parsing(*client, endpoint, params, headers, parsed, is_parsed)
+	: client->Get(endpoint, params, headers);
+
+    if (!response || response->status == 304)
+    {
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	if (cache.data)
+	{
+	    result.load(cache.data, Error(ErrorType::Success));
+	    return result;
+	}
+    }
+
+    if (streaming)
+	result.load(response, std::move(parsed), is_parsed);
+    else
+	result.load(response, client.arena());
+
+    if (!result.is_valid())
+	return result;
+
+    bool changed = true;
+    {
+	std::lock_guard<std::mutex> lock(cache.mutex);
+	cache.etag = response->get_header_value("ETag");
+	cache.last_modified = response->get_header_value("Last-Modified");
+	if (cache.data && !params.empty())
+	{
+	    changed = !cache.data->includes(result.get_data());
+	    if (changed)
+	    {
+		auto merged = std::make_shared<T>(*cache.data);
+		merged->merge(T(result.get_data()));
+		cache.data = std::move(merged);
+	    }
+	    result.load(cache.data, Error(ErrorType::Success));
+	}
+	else
+	{
+	    cache.data = result.get_snapshot();
+	}
+    }
+
+    if (changed)
+	this->save_snapshot(cache);
+
     return result;
 }
 
-const Result<SleepData> Connection::get_sleep() const
+/**
+ * The cached data of the dataset, without any request. It is not valid if
+ * there is not cached data.
+ */
+template <typename T>
+const Result<T> Connection::get_cached(DatasetCache<T>& cache) const
 {
-    httplib::Client client(HOST);
-    client.set_bearer_token_auth(this->token);
-    client.set_connection_timeout(CONNECTION_TIMEOUT_SECONDS, 0);
-    client.set_read_timeout(READ_TIMEOUT_SECONDS, 0);
-    client.set_write_timeout(WRITE_TIMEOUT_SECONDS, 0);
-    auto response = client.Get("/monitorings/sleep/");
-
-    Result<SleepData> result;
-    result.load(response);
+    Result<T> result;
+
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (cache.data)
+	result.load(cache.data, Error(ErrorType::Success));
     return result;
 }
 
+const Result<StepsData> Connection::get_steps() const
+{
+    return this->get_dataset("/monitorings/steps/", *this->steps_cache);
+}
+
+const Result<SleepData> Connection::get_sleep() const
+{
+    return this->get_dataset("/monitorings/sleep/", *this->sleep_cache);
+}
+
 const Result<ActivitiesData> Connection::get_activities() const
 {
-    httplib::Client client(HOST);
-    client.set_bearer_token_auth(this->token);
-    client.set_connection_timeout(CONNECTION_TIMEOUT_SECONDS, 0);
-    client.set_read_timeout(READ_TIMEOUT_SECONDS, 0);
-    client.set_write_timeout(WRITE_TIMEOUT_SECONDS, 0);
-    auto response = client.Get("/activities/");
-
-    Result<ActivitiesData> result;
-    result.load(response);
-    return result;
+    return this->get_dataset("/activities/", *this->activities_cache);
 }
 
-const Result<LapsData> Connection::get_activity_laps(const std::string& activity_id) const
+const Result<StepsData> Connection::get_cached_steps() const
+{
+    return this->get_cached(*this->steps_cache);
+}
+
+const Result<SleepData> Connection::get_cached_sleep() const
 {
-    httplib::Client client(HOST);
-    client.set_bearer_token_auth(this->token);
-    client.set_connection_timeout(CONNECTION_TIMEOUT_SECONDS, 0);
-    client.set_read_timeout(READ_TIMEOUT_SECONDS, 0);
-    client.set_write_timeout(WRITE_TIMEOUT_SECONDS, 0);
-    auto response = client.Get("/activities/" + activity_id + "/laps/");
+    return this->get_cached(*this->sleep_cache);
+}
 
+const Result<ActivitiesData> Connection::get_cached_activities() const
+{
+    return this->get_cached(*this->activities_cache);
+}
+
+const Result<LapsData> Connection::get_activity_laps(const std::string& activity_id) const
+{
     Result<LapsData> result;
-    result.load(response);
+
+    if (auto cached = this->laps_cache->get(activity_id); cached.has_value())
+    {
+	result.load(cached.value(), Error(ErrorType::Success));
+	return result;
+    }
+
+    auto client = this->pool->acquire();
+    auto response = client->Get("/activities/" + activity_id + "/laps/");
+
+    result.load(response, client.arena());
+    if (result.is_valid())
+	this->laps_cache->put(activity_id, result.get_data());
+    return result;
+}
+
+/**
+ * It gets the laps of all the activities concurrently.
+ *
+ * At most CLIENT_POOL_MAX_IDLE requests are in flight, so all of them reuse a
+ * keep-alive client. Results keep the order of activities_ids.
+ */
+const std::vector<Result<LapsData>> Connection::get_activities_laps(
+    const std::vector<std::string>& activities_ids) const
+{
+    std::vector<Result<LapsData>> results(activities_ids.size());
+    parallel_for(
+	activities_ids.size(),
+	CLIENT_POOL_MAX_IDLE,
+	[this, &activities_ids, &results](const size_t i) {
+	    results[i] = this->get_activity_laps(activities_ids[i]);
+	});
+
+    return results;
+}
+
+/**
+ * Records are not cached: they are only requested to analyze an activity.
+ */
+const Result<RecordsData> Connection::get_activity_records(const std::string& activity_id) const
+{
+    Result<RecordsData> result;
+
+    auto client = this->pool->acquire();
+    auto response = client->Get("/activities/" + activity_id + "/records/");
+
+    result.load(response, client.arena());
     return result;
 }
 
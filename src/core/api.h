@@ -1,17 +1,29 @@
 #ifndef _ES_RGMF_CORE_API_H
 #define _ES_RGMF_CORE_API_H 1
 
+#include <cmath>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
 #include <sys/types.h>
 #include <chrono>
 #include <filesystem>
+#include <future>
 #include <string>
 #include <map>
+#include <type_traits>
+#include <variant>
 #include <vector>
 
 #include <httplib/httplib.h>
 #include <rapidjson/document.h>
 
+#include "arena.h"
+#include "../utils/flat_map.h"
+#include "../utils/symbol.h"
+
 namespace fitgalgo
 {
 
@@ -19,18 +31,28 @@ namespace fitgalgo
 constexpr const char *HOST = "https://fitapi.rgmf.es";
 
 constexpr const time_t CONNECTION_TIMEOUT_SECONDS = 60;
+// Login is the first request: if the API cannot be reached, the local
+// snapshots are opened soon instead of after CONNECTION_TIMEOUT_SECONDS.
+constexpr const time_t LOGIN_CONNECTION_TIMEOUT_SECONDS = 5;
 constexpr const time_t READ_TIMEOUT_SECONDS = 300;
 constexpr const time_t WRITE_TIMEOUT_SECONDS = 300;
 
+constexpr const size_t CLIENT_POOL_MAX_IDLE = 8;
+constexpr const size_t UPLOAD_MAX_IN_FLIGHT = 4;
+constexpr const size_t UPLOAD_CHUNK_SIZE = 64 * 1024;
+// The API has to accept gzip encoded request bodies to enable it.
+constexpr const bool UPLOAD_COMPRESSION = false;
+// Datasets are parsed while they are received instead of after it.
+constexpr const bool DATASETS_STREAMING = true;
+
 struct Data
 {
     virtual ~Data() = default;
-    virtual bool load(const rapidjson::Document& document) = 0;
+    virtual bool load(const rapidjson::Value& document) = 0;
 };
 
 /**
- * This class handle a datetime in ISO-8601 format (without zone info) in an
- * string format.
+ * This class handle a datetime in ISO-8601 format (without zone info).
  *
  * Its constructor expects these possibles formats:
  * - yyyy-mm-dd
@@ -40,41 +62,101 @@ struct Data
  * These formats could contains more trailing extra characteres but they will
  * be ignored.
  *
- * In all cases, it keeps the datetime with this format: yyyy-mm-ddThh:mm:ss
- *
  * If hour, minutes and seconds are not provided then it will use 00:00:00
  *
- * If you try to create an object with an invalid string, then it will generate
- * an exception.
+ * The datetime is packed in an integer, from the most significant bits: year
+ * (bits 26 and up), month (4 bits), day (5 bits), hour (5 bits), minutes (6
+ * bits) and seconds (6 bits). So, fields are read with a shift and a mask and
+ * indexes are compared as integers. The string, with the format
+ * yyyy-mm-ddThh:mm:ss, is only built by value().
+ *
+ * If you try to create an object with an invalid string, then it is an
+ * invalid index (0): is_valid() returns false and the fields are -1.
  */
 class DateIdx
 {
 private:
-    std::string datetime{};
+    uint64_t packed{};
+
+    static constexpr uint64_t pack(
+	const int year, const unsigned month, const unsigned day,
+	const unsigned hour = 0, const unsigned minute = 0, const unsigned second = 0)
+    {
+	return static_cast<uint64_t>(year) << 26 | month << 22 | day << 17 |
+	    hour << 12 | minute << 6 | second;
+    }
+
+    // -1 for the fields of an invalid index, whose bits are 0.
+    short field(const unsigned shift, const uint64_t mask) const
+    {
+	return static_cast<short>((packed >> shift) & mask) - static_cast<short>(packed == 0);
+    }
 
-    inline void set_datetime_if_valid_value(const std::string& value, const std::string& format);
     inline void decrement_date();
 
 public:
-    explicit DateIdx() : datetime() {}
+    explicit DateIdx() : packed() {}
     explicit DateIdx(const std::string& value);
-    const std::string& value() const;
-    std::chrono::year_month_day ymd() const;
-    short year() const;
-    short month() const;
-    short day() const;
-    bool is_valid() const;
+    explicit DateIdx(const std::chrono::year_month_day& ymd)
+	: packed{pack(
+	      static_cast<int>(ymd.year()),
+	      static_cast<unsigned>(ymd.month()),
+	      static_cast<unsigned>(ymd.day()))} {}
+    std::string value() const;
+    std::chrono::year_month_day ymd() const
+    {
+	return std::chrono::year(year()) / std::chrono::month(month()) / std::chrono::day(day());
+    }
+    short year() const { return field(26, 0x3fff); }
+    short month() const { return field(22, 0xf); }
+    short day() const { return field(17, 0x1f); }
+    short hour() const { return field(12, 0x1f); }
+    short minute() const { return field(6, 0x3f); }
+    short second() const { return field(0, 0x3f); }
+    bool is_valid() const { return packed != 0; }
     DateIdx& operator--(int);
     DateIdx& operator--();
-    friend bool operator<(const DateIdx& l, const DateIdx& r);
+    friend auto operator<=>(const DateIdx& l, const DateIdx& r) = default;
 };
 
+/**
+ * Items of a dataset from the day from to the day to (both included) as a
+ * range of iterators. They are found with binary searches, so dashboards jump
+ * to their dates without scanning the history.
+ */
+template <typename T>
+std::ranges::subrange<typename FlatMap<DateIdx, T>::const_iterator> date_range(
+    const FlatMap<DateIdx, T>& items,
+    const std::chrono::year_month_day& from,
+    const std::chrono::year_month_day& to)
+{
+    return items.range(DateIdx(from), DateIdx(std::chrono::sys_days(to) + std::chrono::days(1)));
+}
+
+template <typename T>
+std::ranges::subrange<typename FlatMap<DateIdx, T>::const_iterator> year_range(
+    const FlatMap<DateIdx, T>& items, const int year)
+{
+    return date_range(
+	items,
+	std::chrono::year(year) / std::chrono::January / 1,
+	std::chrono::year(year) / std::chrono::December / 31);
+}
+
+template <typename T>
+std::ranges::subrange<typename FlatMap<DateIdx, T>::const_iterator> month_range(
+    const FlatMap<DateIdx, T>& items, const int year, const unsigned month)
+{
+    const auto first = std::chrono::year(year) / std::chrono::month(month) / 1;
+    return date_range(items, first, std::chrono::year_month_day_last(first.year(), first.month() / std::chrono::last));
+}
+
 struct LoginData : public Data
 {
     std::string access_token{};
     std::string token_type{};
 
-    bool load(const rapidjson::Document& document) override;
+    bool load(const rapidjson::Value& document) override;
 };
 
 struct UploadedFile
@@ -91,7 +173,7 @@ struct UploadedFileData : public Data
     std::vector<UploadedFile> uploaded_files{};
     std::vector<std::string> errors{};
 
-    bool load(const rapidjson::Document& document) override;
+    bool load(const rapidjson::Value& document) override;
 };
 
 struct Steps
@@ -101,14 +183,28 @@ struct Steps
     int steps{};
     float distance{};
     int calories{};
+
+    bool operator==(const Steps& other) const = default;
 };
 
-struct StepsData : public Data
+/**
+ * Steps by day. Datasets are not Data: they are filled by SAX parsers (see
+ * sax.h) without building a DOM.
+ */
+struct StepsData
 {
-    std::map<DateIdx, Steps> steps{};
+    FlatMap<DateIdx, Steps> steps{};
     std::vector<std::string> errors{};
 
-    bool load(const rapidjson::Document& document) override;
+    // Index of the newest day, or an invalid index if there are not steps. Only
+    // the days since it are requested to synchronize the dataset.
+    DateIdx newest() const;
+    // It adds the days of other, replacing the ones already here. The errors
+    // are replaced too: they are the ones of the last response, so they do not
+    // pile up sync after sync.
+    void merge(StepsData&& other);
+    // If merging other would not change this dataset.
+    bool includes(const StepsData& other) const;
 };
 
 struct SleepAssessment
@@ -127,30 +223,53 @@ struct SleepAssessment
     float awakenings_count{};
     float interruptions_score{};
     float average_stress_during_sleep{};
+
+    bool operator==(const SleepAssessment& other) const = default;
 };
 
+enum class SleepStage : uint8_t {
+  UNMEASURABLE = 0,
+  AWAKE,
+  LIGHT,
+  DEEP,
+  REM
+};
+const std::string sleep_stage_names[] = { "unmeasurable", "awake", "light", "deep", "rem" };
+
+/**
+ * A transition of the sleep stages, decoded when it is loaded: the time (UTC)
+ * as seconds since the epoch and the stage from then.
+ */
 struct SleepLevel
 {
-    std::string datetime_utc{};
-    std::string level{};
+    int64_t timestamp{};
+    SleepStage stage{SleepStage::UNMEASURABLE};
+
+    bool operator==(const SleepLevel& other) const = default;
 };
 
 struct Sleep
 {
-    std::string zone_info{};
+    Symbol zone_info{};
     SleepAssessment assessment{};
     std::vector<SleepLevel> levels{};
     std::vector<std::string> dates{};
 
     bool is_early_morning() const;
+
+    bool operator==(const Sleep& other) const = default;
 };
 
-struct SleepData : public Data
+struct SleepData
 {
-    std::map<DateIdx, Sleep> sleep{};
+    FlatMap<DateIdx, Sleep> sleep{};
     std::vector<std::string> errors{};
 
-    bool load(const rapidjson::Document& document) override;
+    // Index of the newest night, or an invalid index if it is empty.
+    DateIdx newest() const;
+    // Like StepsData::merge: nights of other replace the ones with their index.
+    void merge(SleepData&& other);
+    bool includes(const SleepData& other) const;
 };
 
 enum class ActivityType {
@@ -165,11 +284,11 @@ std::ostream& operator<<(std::ostream& os, ActivityType at);
 struct Activity
 {
     std::string id{};
-    std::string zone_info{};
-    std::string username{};
-    std::string sport_profile_name{};
-    std::string sport{};
-    std::string sub_sport{};
+    Symbol zone_info{};
+    Symbol username{};
+    Symbol sport_profile_name{};
+    Symbol sport{};
+    Symbol sub_sport{};
     std::optional<std::pair<float, float>> start_lat_lon{};
     std::optional<std::pair<float, float>> end_lat_lon{};
     std::string start_time_utc{};
@@ -197,7 +316,7 @@ struct Activity
     std::optional<float> total_training_effect{};
     std::optional<float> total_anaerobic_training_effect{};
 
-    virtual ActivityType get_id() const;
+    bool operator==(const Activity& other) const = default;
 };
 
 enum class SetType {
@@ -215,18 +334,20 @@ struct Set
     int repetitions{};
     float weight{};
     std::string start_time{};
-    std::vector<std::string> category{};
-    std::vector<std::string> category_subtype{};
+    std::vector<Symbol> category{};
+    std::vector<Symbol> category_subtype{};
     std::string weight_display_unit{};
     int message_index{};
     int wkt_step_index{};
+
+    bool operator==(const Set& other) const = default;
 };
 
 struct SetsActivity : public Activity
 {
     std::vector<Set> sets{};
 
-    ActivityType get_id() const override;
+    bool operator==(const SetsActivity& other) const = default;
 };
 
 enum class SplitResult {
@@ -248,38 +369,83 @@ struct Split
     int total_calories{};
     int difficulty{};
     SplitResult result{SplitResult::UNKNOWN};
+
+    bool operator==(const Split& other) const = default;
 };
 
 struct SplitsActivity : public Activity
 {
     std::vector<Split> splits{};
 
-    ActivityType get_id() const override;
+    bool operator==(const SplitsActivity& other) const = default;
 };
 
+// Positions of the records are in semicircles, as in the FIT files: 2^31
+// semicircles are 180 degrees. So, they are kept without losing precision.
+// This is the value of a missing position.
+constexpr const int32_t SEMICIRCLES_INVALID = INT32_MAX;
+
+inline double semicircles_to_degrees(const int32_t semicircles)
+{
+    return semicircles * (180.0 / 2147483648.0);
+}
+
+/**
+ * A sample of the records of an activity (about one per second). The
+ * timestamp is the time (UTC) as seconds since the epoch. Values not in the
+ * sample are NaN (0 for the integer ones, the timestamp included, and
+ * SEMICIRCLES_INVALID for the position).
+ *
+ * It is only a row used to decode the samples: they are stored by columns in
+ * Records.
+ */
 struct Record
 {
-    float timestamp{};
-    std::string activity_type{};
-    std::pair<float, float> position_lat_lon{};
-    int gps_accuracy{};
-    float distance{};
-    float speed{};
-    int vertical_speed{};
-    int power{};
-    float altitude{};
-    int ascent_rate{};
-    int grade{};
+    int64_t timestamp{};
+    std::pair<int32_t, int32_t> position_lat_lon{SEMICIRCLES_INVALID, SEMICIRCLES_INVALID};
+    float distance{NAN};
+    float speed{NAN};
     int heart_rate{};
+    int power{};
     int cadence{};
-    int temperature{};
-    int calories{};
-    int total_cycles{};
-    int step_length{};
-    int absolute_pressure{};
-    float respiration_rate{};
-    int current_stress{};
-    int zone{};
+    float altitude{NAN};
+};
+
+/**
+ * Records of an activity stored as a structure of arrays: a contiguous column
+ * per field, all of them of size() values. Analytics over a field only read
+ * its column, so they are cache friendly and can be vectorized.
+ *
+ * Positions are integer semicircles (see semicircles_to_degrees).
+ */
+struct Records
+{
+    std::vector<int64_t> timestamp{};
+    std::vector<int32_t> position_lat{};
+    std::vector<int32_t> position_long{};
+    std::vector<float> distance{};
+    std::vector<float> speed{};
+    std::vector<int> heart_rate{};
+    std::vector<int> power{};
+    std::vector<int> cadence{};
+    std::vector<float> altitude{};
+
+    size_t size() const { return timestamp.size(); }
+    bool empty() const { return timestamp.empty(); }
+    void reserve(const size_t n);
+    void clear();
+    void push_back(const Record& record);
+    Record operator[](const size_t i) const;
+
+    // Missing values (NaN) are never equal, so records with gaps are always
+    // different: an activity with them is merged again, which is harmless.
+    bool operator==(const Records& other) const = default;
+};
+
+struct RecordsData
+{
+    Records records{};
+    std::vector<std::string> errors{};
 };
 
 struct Lap
@@ -334,6 +500,8 @@ struct Lap
 
     int avg_respiration_rate{};
     int max_respiration_rate{};
+
+    bool operator==(const Lap& other) const = default;
 };
 
 struct LapsData : public Data
@@ -343,28 +511,65 @@ struct LapsData : public Data
 
     LapsData() : laps(), errors() {}
 
-    bool load(const rapidjson::Document& document) override;
+    bool load(const rapidjson::Value& document) override;
 };
 
 struct DistanceActivity : public Activity
 {
-    std::vector<Record> records{};
+    Records records{};
     std::vector<Lap> laps{};
 
-    ActivityType get_id() const override;
+    bool operator==(const DistanceActivity& other) const = default;
 };
 
-struct ActivitiesData : public Data
+/**
+ * An activity of any type stored by value, so activities are contiguous in
+ * their containers and they are copied without allocating them one by one.
+ *
+ * The index of the alternative is its ActivityType (see get_type) and the
+ * fields common to all of them are read through as_activity, without virtual
+ * methods nor RTTI.
+ */
+using AnyActivity = std::variant<Activity, DistanceActivity, SplitsActivity, SetsActivity>;
+
+static_assert(std::is_same_v<
+	      std::variant_alternative_t<static_cast<size_t>(ActivityType::DISTANCE), AnyActivity>,
+	      DistanceActivity>);
+static_assert(std::is_same_v<
+	      std::variant_alternative_t<static_cast<size_t>(ActivityType::SPLITS), AnyActivity>,
+	      SplitsActivity>);
+static_assert(std::is_same_v<
+	      std::variant_alternative_t<static_cast<size_t>(ActivityType::SETS), AnyActivity>,
+	      SetsActivity>);
+
+inline ActivityType get_type(const AnyActivity& a)
+{
+    return static_cast<ActivityType>(a.index());
+}
+
+inline const Activity& as_activity(const AnyActivity& a)
 {
-    std::map<DateIdx, std::unique_ptr<Activity>> activities{};
+    return std::visit([](const Activity& activity) -> const Activity& { return activity; }, a);
+}
+
+inline Activity& as_activity(AnyActivity& a)
+{
+    return std::visit([](Activity& activity) -> Activity& { return activity; }, a);
+}
+
+struct ActivitiesData
+{
+    FlatMap<DateIdx, AnyActivity> activities{};
     std::vector<std::string> errors{};
 
     ActivitiesData() : activities(), errors() {}
-    ActivitiesData(const ActivitiesData& other);
-
-    ActivitiesData& operator=(const ActivitiesData& other);
 
-    bool load(const rapidjson::Document& document) override;
+    // Index of the newest activity, or an invalid index if it is empty.
+    DateIdx newest() const;
+    // Like StepsData::merge: activities of other replace the ones with their
+    // index.
+    void merge(ActivitiesData&& other);
+    bool includes(const ActivitiesData& other) const;
 };
 
 enum class ErrorType {
@@ -393,56 +598,225 @@ public:
 	: error(error), httplib_error(httplib_error) {}
 
     bool has_error() const;
+    ErrorType get_type() const { return error; }
     std::string error_to_string() const;
 };
 
+/**
+ * Result of a request: its error and the data of the response.
+ *
+ * Data is an immutable snapshot shared by every copy of the result. So,
+ * copying a result, or keeping its snapshot (get_snapshot), costs the same
+ * whatever the size of the data: datasets are shared by the cache, the
+ * screens and the stats instead of being copied.
+ */
 template <typename T>
 class Result
 {
 private:
     Error error{};
     int status{};
-    std::unique_ptr<T> data{};
+    std::shared_ptr<const T> data{};
 
-public:
-    explicit Result();
-    Result(const Result<T>& other);
-    Result(Result<T>&& other) noexcept;
+    bool load_status(const httplib::Result& response);
 
-    Result<T>& operator=(const Result<T>& other);
-    Result<T>& operator=(const Result<T>&& other) noexcept;
+public:
+    explicit Result() = default;
 
-    void load(const httplib::Result& response);
-    void load(const T& newData);
+    void load(httplib::Result& response, JsonArena& arena);
+    void load(const httplib::Result& response, T&& parsedData, const bool is_parsed);
+    void load(const T& newData, const Error& newError = Error());
+    void load(std::shared_ptr<const T> snapshot, const Error& newError = Error());
     bool is_valid() const { return !this->error.has_error(); }
     const Error get_error() const { return error; }
     const T& get_data() const { return *this->data; }
+    std::shared_ptr<const T> get_snapshot() const { return this->data; }
+};
+
+class LapsCache;
+
+/**
+ * Last valid response of a dataset endpoint: its validators (ETag and
+ * Last-Modified headers) and the data parsed from it.
+ *
+ * It is used to make conditional requests: when the API answers 304 Not
+ * Modified the data is reused without downloading and parsing it again.
+ *
+ * If snapshot is not empty, the cache is saved in that file (in binary format)
+ * after every update, so it can be loaded on the next run even if there is no
+ * connection. It is written in the background (saving): every save holds the
+ * future of the previous one and waits for it before writing, so the newest
+ * data is the last written.
+ *
+ * Data is the snapshot shared with the results, so it is never modified: new
+ * records are merged into a copy that replaces it.
+ */
+template <typename T>
+struct DatasetCache
+{
+    std::mutex mutex{};
+    std::string etag{};
+    std::string last_modified{};
+    std::shared_ptr<const T> data{};
+    std::filesystem::path snapshot{};
+    std::mutex saving_mutex{};
+    std::future<void> saving{};
+};
+
+/**
+ * Pool of keep-alive HTTP clients against one host.
+ *
+ * Every client is configured once with the bearer token and the timeouts, so
+ * consecutive requests reuse the same TCP/TLS connection instead of paying the
+ * handshake again. Clients ask for gzip/deflate encoded responses, which are
+ * decompressed while they are received.
+ *
+ * Every client has its own JsonArena to parse its responses, so the memory of
+ * the documents is also reused between requests.
+ *
+ * A client is borrowed with acquire() and it comes back to the pool when the
+ * Lease goes out of scope. A client is never shared by two threads at the same
+ * time. At most CLIENT_POOL_MAX_IDLE idle clients are kept.
+ *
+ * The pool must be owned by a std::shared_ptr because leases keep it alive.
+ */
+class ClientPool : public std::enable_shared_from_this<ClientPool>
+{
+private:
+    struct Item
+    {
+	std::unique_ptr<httplib::Client> client{};
+	std::unique_ptr<JsonArena> arena{};
+    };
+
+    std::string host;
+    std::string token;
+    std::mutex mutex;
+    std::vector<Item> idle;
+
+    Item make_item() const;
+    void release(Item item);
+
+public:
+    class Lease
+    {
+    private:
+	std::shared_ptr<ClientPool> pool;
+	Item item;
+
+    public:
+	explicit Lease(std::shared_ptr<ClientPool> pool, Item item)
+	    : pool(std::move(pool)), item(std::move(item)) {}
+	Lease(const Lease& other) = delete;
+	Lease(Lease&& other) noexcept = default;
+	~Lease();
+
+	Lease& operator=(const Lease& other) = delete;
+
+	httplib::Client& operator*() const { return *item.client; }
+	httplib::Client* operator->() const { return item.client.get(); }
+	JsonArena& arena() const { return *item.arena; }
+    };
+
+    explicit ClientPool(const std::string& host, const std::string& token)
+	: host{host}, token{token}, mutex{}, idle{} {}
+    ClientPool(const ClientPool& other) = delete;
+
+    ClientPool& operator=(const ClientPool& other) = delete;
+
+    Lease acquire();
 };
 
 /**
  * Class for getting data from Fit Galgo API.
  *
  * It also manages login, logout and the token.
+ *
+ * All the requests borrow a client from a ClientPool that is shared by the
+ * copies of the connection, so they reuse the keep-alive connections. The pool
+ * is replaced every time the token changes (login and logout).
+ *
+ * Laps are looked up in a LapsCache, also shared by the copies, before they
+ * are requested to the API. Steps, sleep and activities are requested with
+ * If-None-Match/If-Modified-Since headers and the last parsed data is reused
+ * when they have not changed (see DatasetCache).
+ *
+ * Once a dataset is cached, only records since its newest one are requested
+ * (since parameter), so the transfer and the parsing depend on the new data
+ * and not on the whole history. If they change the cache, they are merged into
+ * a copy of it (the cached data can be in use) that is saved in the
+ * background, so only changes cost a pass over the history.
+ *
+ * Datasets caches are saved as snapshots per user and they are loaded on
+ * login. They can also be opened without connection (see open_offline) and,
+ * then, the datasets are served from them. The cached datasets are available
+ * at once (get_cached_*), without any request, while they are revalidated.
+ *
+ * In streaming mode (see set_streaming) the body of the datasets is given to
+ * their parsers as it is received, so parsing overlaps with the transfer. The
+ * full download of the activities is the exception: it is buffered and parsed
+ * in several threads (see HAS_PARALLEL_PARSE).
  */
 class Connection
 {
 private:
+    std::string host;
     std::string token;
+    std::string username;
+    bool offline;
+    bool streaming;
+    std::shared_ptr<ClientPool> pool;
+    std::shared_ptr<LapsCache> laps_cache;
+    std::shared_ptr<DatasetCache<StepsData>> steps_cache;
+    std::shared_ptr<DatasetCache<SleepData>> sleep_cache;
+    std::shared_ptr<DatasetCache<ActivitiesData>> activities_cache;
+
+    void reset_datasets_caches();
+
+    template <typename T>
+    void load_snapshot(DatasetCache<T>& cache) const;
+    template <typename T>
+    void save_snapshot(DatasetCache<T>& cache) const;
+
+    template <typename T>
+    const Result<T> get_dataset(const std::string& endpoint, DatasetCache<T>& cache) const;
+    template <typename T>
+    const Result<T> get_cached(DatasetCache<T>& cache) const;
 
     const Result<UploadedFileData> do_post_for_file(
-	httplib::Client& client, const std::filesystem::path& file_path) const;
+	ClientPool::Lease& client, const std::filesystem::path& file_path) const;
 
 public:
-    explicit Connection() : token{} {}
-    Connection(const Connection& other) : token{other.token} {}
+    explicit Connection(const std::string& host = HOST);
+    Connection(const Connection& other)
+	: host{other.host},
+	  token{other.token},
+	  username{other.username},
+	  offline{other.offline},
+	  streaming{other.streaming},
+	  pool{other.pool},
+	  laps_cache{other.laps_cache},
+	  steps_cache{other.steps_cache},
+	  sleep_cache{other.sleep_cache},
+	  activities_cache{other.activities_cache} {}
     const Result<LoginData> login(const std::string& username, const std::string& password);
     void logout();
     bool has_token() const;
-    const std::vector<Result<UploadedFileData>> post_file(std::filesystem::path& path) const;
+    bool open_offline(const std::string& username);
+    bool is_offline() const;
+    void set_streaming(const bool streaming);
+    const std::vector<Result<UploadedFileData>> post_file(
+	std::filesystem::path& path, const size_t in_flight = UPLOAD_MAX_IN_FLIGHT) const;
     const Result<StepsData> get_steps() const;
     const Result<SleepData> get_sleep() const;
     const Result<ActivitiesData> get_activities() const;
+    const Result<StepsData> get_cached_steps() const;
+    const Result<SleepData> get_cached_sleep() const;
+    const Result<ActivitiesData> get_cached_activities() const;
     const Result<LapsData> get_activity_laps(const std::string& activity_id) const;
+    const std::vector<Result<LapsData>> get_activities_laps(
+	const std::vector<std::string>& activities_ids) const;
+    const Result<RecordsData> get_activity_records(const std::string& activity_id) const;
 };
 
 } // namespace fitgalgo
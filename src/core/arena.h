@@ -0,0 +1,92 @@
+#ifndef _ES_RGMF_CORE_ARENA_H
+#define _ES_RGMF_CORE_ARENA_H 1
+
+#include <bit>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include <rapidjson/document.h>
+
+namespace fitgalgo
+{
+
+// Initial size of the buffer of a JsonArena. It grows to fit the documents.
+constexpr const size_t JSON_ARENA_SIZE = 64 * 1024;
+// Size of the buffer of the parse stack of a JsonArena.
+constexpr const size_t JSON_ARENA_STACK_SIZE = 16 * 1024;
+
+/**
+ * Memory reused to parse JSON documents into a DOM.
+ *
+ * Values are allocated in a rapidjson::MemoryPoolAllocator over a buffer that
+ * is reset, not freed, before every parse. If a document does not fit, the
+ * buffer grows to its size for the next parses.
+ *
+ * The parse stack has its own pool over a fixed buffer. The document "frees"
+ * its stack after every parse, which is a no-op for a pool, so the pool is
+ * also reset before every parse: otherwise every parse would take a new stack
+ * from it. Stacks bigger than the buffer are allocated and freed on the next
+ * reset.
+ *
+ * Documents are parsed in situ: strings point to the JSON buffer, which is
+ * modified, instead of being copied. So, the document is valid while the JSON
+ * buffer is alive and until the next parse.
+ *
+ * Only the responses loaded as Data use it (login, uploads and laps). The
+ * datasets and the records are parsed by their SAX parsers (see sax.h), which
+ * do not build a DOM.
+ *
+ * It is not thread safe: every ClientPool client has its own arena.
+ */
+class JsonArena
+{
+public:
+    using Allocator = rapidjson::MemoryPoolAllocator<>;
+    using Document = rapidjson::GenericDocument<rapidjson::UTF8<>, Allocator, Allocator>;
+
+private:
+    size_t capacity;
+    std::unique_ptr<char[]> buffer;
+    std::optional<Allocator> values;
+    std::unique_ptr<char[]> stack_buffer;
+    Allocator stack;
+    Document document;
+
+public:
+    explicit JsonArena(const size_t capacity = JSON_ARENA_SIZE)
+	: capacity{capacity},
+	  buffer{new char[capacity]},
+	  values{std::in_place, buffer.get(), capacity},
+	  stack_buffer{new char[JSON_ARENA_STACK_SIZE]},
+	  stack{stack_buffer.get(), JSON_ARENA_STACK_SIZE},
+	  document{&values.value(), 1024, &stack} {}
+    JsonArena(const JsonArena& other) = delete;
+
+    JsonArena& operator=(const JsonArena& other) = delete;
+
+    const Document& parse(std::string& json)
+    {
+	if (this->values->Size() > this->capacity)
+	{
+	    // The allocator is built again in the same place, so the document
+	    // keeps pointing to it.
+	    this->capacity = std::bit_ceil(this->values->Size());
+	    this->values.reset();
+	    this->buffer.reset(new char[this->capacity]);
+	    this->values.emplace(this->buffer.get(), this->capacity);
+	}
+	else
+	{
+	    this->values->Clear();
+	}
+	this->stack.Clear();
+
+	this->document.ParseInsitu(json.data());
+	return this->document;
+    }
+};
+
+} // namespace fitgalgo
+
+#endif // _ES_RGMF_CORE_ARENA_H
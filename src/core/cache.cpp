@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+
+#include "cache.h"
+#include "serialize.h"
+
+namespace fitgalgo
+{
+
+std::filesystem::path cache_dir()
+{
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg != nullptr && *xdg != '\0')
+	return std::filesystem::path(xdg) / "fitgalgo";
+    if (const char* home = std::getenv("HOME"); home != nullptr && *home != '\0')
+	return std::filesystem::path(home) / ".cache" / "fitgalgo";
+    return std::filesystem::temp_directory_path() / "fitgalgo";
+}
+
+bool is_safe_file_name(const std::string& name)
+{
+    return !name.empty() && name.front() != '.' &&
+	std::all_of(name.cbegin(), name.cend(), [](const char c) {
+	    return std::isalnum(static_cast<unsigned char>(c)) ||
+		c == '-' || c == '_' || c == '.' || c == '@';
+	});
+}
+
+std::optional<std::string> read_file(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+	return {};
+
+    const auto size = file.tellg();
+    if (size < 0)
+	return {};
+
+    std::string content(static_cast<size_t>(size), '\0');
+    file.seekg(0);
+    if (!file.read(content.data(), size))
+	return {};
+
+    return content;
+}
+
+bool write_file(const std::filesystem::path& path, const std::string& content)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    auto tmp_path = path;
+    tmp_path += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+    {
+	std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	    return false;
+	file.write(content.data(), content.size());
+	if (!file.good())
+	    return false;
+    }
+
+    std::filesystem::rename(tmp_path, path, ec);
+    return !ec;
+}
+
+std::optional<std::filesystem::path> LapsCache::file_path(const std::string& activity_id) const
+{
+    if (!is_safe_file_name(activity_id))
+	return {};
+
+    return this->dir / (activity_id + ".bin");
+}
+
+std::optional<LapsData> LapsCache::load(const std::string& activity_id) const
+{
+    const auto path = this->file_path(activity_id);
+    if (!path.has_value())
+	return {};
+
+    const auto content = read_file(path.value());
+    if (!content.has_value())
+	return {};
+
+    LapsData laps{};
+    BinaryReader reader{content.value()};
+    if (!deserialize(reader, laps))
+	return {};
+
+    return laps;
+}
+
+void LapsCache::store(const std::string& activity_id, const LapsData& laps) const
+{
+    const auto path = this->file_path(activity_id);
+    if (!path.has_value())
+	return;
+
+    BinaryWriter writer{};
+    serialize(writer, laps);
+    write_file(path.value(), writer.data());
+}
+
+void LapsCache::insert(const std::string& activity_id, const LapsData& laps)
+{
+    if (auto itr = this->index.find(activity_id); itr != this->index.end())
+    {
+	itr->second->second = laps;
+	this->items.splice(this->items.begin(), this->items, itr->second);
+	return;
+    }
+
+    this->items.emplace_front(activity_id, laps);
+    this->index[activity_id] = this->items.begin();
+
+    if (this->items.size() > LAPS_CACHE_CAPACITY)
+    {
+	this->index.erase(this->items.back().first);
+	this->items.pop_back();
+    }
+}
+
+std::optional<LapsData> LapsCache::get(const std::string& activity_id)
+{
+    {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	if (auto itr = this->index.find(activity_id); itr != this->index.end())
+	{
+	    this->items.splice(this->items.begin(), this->items, itr->second);
+	    return itr->second->second;
+	}
+    }
+
+    auto laps = this->load(activity_id);
+    if (laps.has_value())
+    {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->insert(activity_id, laps.value());
+    }
+
+    return laps;
+}
+
+void LapsCache::put(const std::string& activity_id, const LapsData& laps)
+{
+    {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->insert(activity_id, laps);
+    }
+
+    this->store(activity_id, laps);
+}
+
+} // namespace fitgalgo
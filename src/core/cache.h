@@ -0,0 +1,78 @@
+#ifndef _ES_RGMF_CORE_CACHE_H
+#define _ES_RGMF_CORE_CACHE_H 1
+
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "api.h"
+
+namespace fitgalgo
+{
+
+constexpr const size_t LAPS_CACHE_CAPACITY = 256;
+
+/**
+ * Directory where the application keeps its local caches:
+ * $XDG_CACHE_HOME/fitgalgo or $HOME/.cache/fitgalgo.
+ */
+std::filesystem::path cache_dir();
+
+/**
+ * It checks the name can be used as a file name inside a cache directory: it
+ * is not empty, it does not start with a dot and it only has alphanumeric
+ * characters and '-', '_', '.', '@'.
+ */
+bool is_safe_file_name(const std::string& name);
+
+/**
+ * It reads the whole file with a single read. It returns nothing if the file
+ * cannot be read.
+ */
+std::optional<std::string> read_file(const std::filesystem::path& path);
+
+/**
+ * It writes the content into a temporary file and renames it to path, so
+ * readers never see a half written file. Parent directories are created.
+ */
+bool write_file(const std::filesystem::path& path, const std::string& content);
+
+/**
+ * Cache of the laps of the activities, keyed by Activity::id.
+ *
+ * Laps of a finished activity never change, so they are kept in a LRU of, at
+ * most, LAPS_CACHE_CAPACITY items in memory backed by one binary file per
+ * activity in a directory. It is safe to use it from several threads.
+ */
+class LapsCache
+{
+private:
+    using Item = std::pair<std::string, LapsData>;
+
+    std::filesystem::path dir;
+    std::mutex mutex;
+    std::list<Item> items;
+    std::unordered_map<std::string, std::list<Item>::iterator> index;
+
+    std::optional<std::filesystem::path> file_path(const std::string& activity_id) const;
+    std::optional<LapsData> load(const std::string& activity_id) const;
+    void store(const std::string& activity_id, const LapsData& laps) const;
+    void insert(const std::string& activity_id, const LapsData& laps);
+
+public:
+    explicit LapsCache(const std::filesystem::path& dir)
+	: dir{dir}, mutex{}, items{}, index{} {}
+    LapsCache(const LapsCache& other) = delete;
+
+    LapsCache& operator=(const LapsCache& other) = delete;
+
+    std::optional<LapsData> get(const std::string& activity_id);
+    void put(const std::string& activity_id, const LapsData& laps);
+};
+
+} // namespace fitgalgo
+
+#endif // _ES_RGMF_CORE_CACHE_H
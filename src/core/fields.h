@@ -0,0 +1,428 @@
+#ifndef _ES_RGMF_CORE_FIELDS_H
+#define _ES_RGMF_CORE_FIELDS_H 1
+
+#include <array>
+#include <bit>
+#include <bitset>
+#include <cfloat>
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <rapidjson/document.h>
+
+#include "api.h"
+#include "../utils/string.h"
+
+namespace fitgalgo
+{
+
+/**
+ * A scalar JSON value, read from a rapidjson::Value or from a SAX event.
+ *
+ * Types are checked like rapidjson::Value does: a float is a number with
+ * decimals and an int is an integer number in the int range, but both of
+ * them are numbers.
+ */
+struct JsonScalar
+{
+    enum class Kind { Null, Bool, Int, Double, String };
+
+    Kind kind{Kind::Null};
+    bool boolean{};
+    int64_t integer{};
+    double number{};
+    std::string_view string{};
+
+    bool is_int() const { return kind == Kind::Int && integer >= INT_MIN && integer <= INT_MAX; }
+    bool is_float() const { return kind == Kind::Double && number >= -FLT_MAX && number <= FLT_MAX; }
+    bool is_number() const { return kind == Kind::Int || kind == Kind::Double; }
+    bool is_string() const { return kind == Kind::String; }
+
+    int get_int() const { return static_cast<int>(integer); }
+    float get_float() const
+    {
+	return kind == Kind::Int ? static_cast<float>(integer) : static_cast<float>(number);
+    }
+    std::string get_string() const { return std::string(string); }
+};
+
+inline JsonScalar to_scalar(const rapidjson::Value& value)
+{
+    if (value.IsString())
+	return {.kind = JsonScalar::Kind::String,
+		.string = std::string_view(value.GetString(), value.GetStringLength())};
+    if (value.IsBool())
+	return {.kind = JsonScalar::Kind::Bool, .boolean = value.GetBool()};
+    if (value.IsInt64())
+	return {.kind = JsonScalar::Kind::Int, .integer = value.GetInt64()};
+    if (value.IsNumber())
+	return {.kind = JsonScalar::Kind::Double, .number = value.GetDouble()};
+    return {};
+}
+
+/**
+ * Type expected for the value of a field. Values of other types are ignored.
+ * - Int: integer number.
+ * - Float: number with decimals.
+ * - Number: any number.
+ * - String: to a std::string or a Symbol (interned).
+ */
+enum class JsonType { Int, Float, Number, String };
+
+/**
+ * Descriptor of a field of the struct S loaded from a JSON object: its key,
+ * the key used when the object has not it (fallback_key, optional) and the
+ * function that assigns the value to the member.
+ *
+ * Use field<&S::member, JsonType>(key, fallback_key) to create them.
+ */
+template <typename S>
+struct Field
+{
+    std::string_view key{};
+    std::string_view fallback_key{};
+    bool (*assign)(S& item, const JsonScalar& value){};
+};
+
+template <typename M>
+struct MemberPointer;
+
+template <typename S, typename M>
+struct MemberPointer<M S::*>
+{
+    using Struct = S;
+    using Member = M;
+};
+
+template <auto member, JsonType type>
+bool assign_field(typename MemberPointer<decltype(member)>::Struct& item, const JsonScalar& value)
+{
+    using Member = typename MemberPointer<decltype(member)>::Member;
+
+    if constexpr (type == JsonType::Int)
+    {
+	if (!value.is_int())
+	    return false;
+	item.*member = static_cast<Member>(value.get_int());
+    }
+    else if constexpr (type == JsonType::Float)
+    {
+	if (!value.is_float())
+	    return false;
+	item.*member = static_cast<Member>(value.get_float());
+    }
+    else if constexpr (type == JsonType::Number)
+    {
+	if (!value.is_number())
+	    return false;
+	// Integer members (as timestamps) take the whole value: a float has not
+	// enough precision for them.
+	if constexpr (std::is_integral_v<Member>)
+	    item.*member = value.kind == JsonScalar::Kind::Int
+		? static_cast<Member>(value.integer) : static_cast<Member>(value.number);
+	else
+	    item.*member = static_cast<Member>(value.get_float());
+    }
+    else
+    {
+	if (!value.is_string())
+	    return false;
+	if constexpr (std::is_same_v<Member, Symbol>)
+	    item.*member = Symbol(value.string);
+	else
+	    item.*member = value.get_string();
+    }
+    return true;
+}
+
+template <auto member, JsonType type>
+constexpr Field<typename MemberPointer<decltype(member)>::Struct> field(
+    const std::string_view key, const std::string_view fallback_key = {})
+{
+    return {key, fallback_key, &assign_field<member, type>};
+}
+
+/**
+ * Table of the fields of a struct, built at compile time.
+ *
+ * Keys (and fallback keys) are stored in an open addressing hash table by
+ * their str_hash, so finding the field of a key does not depend on the number
+ * of fields. Duplicated keys are a compilation error.
+ */
+template <typename S, size_t N>
+class FieldTable
+{
+public:
+    using Struct = S;
+    static constexpr size_t SIZE = N;
+
+    struct Slot
+    {
+	uint64_t hash{};
+	uint16_t field{};
+	bool is_fallback{};
+	bool is_used{};
+    };
+
+private:
+    static constexpr size_t SLOTS = std::bit_ceil(4 * N);
+
+    std::array<Field<S>, N> fields;
+    std::array<Slot, SLOTS> slots;
+
+    constexpr std::string_view key_of(const Slot& slot) const
+    {
+	return slot.is_fallback ? fields[slot.field].fallback_key : fields[slot.field].key;
+    }
+
+    constexpr void insert(const std::string_view key, const uint16_t field, const bool is_fallback)
+    {
+	const auto hash = str_hash(key);
+	for (size_t i = hash & (SLOTS - 1); ; i = (i + 1) & (SLOTS - 1))
+	{
+	    if (!slots[i].is_used)
+	    {
+		slots[i] = {hash, field, is_fallback, true};
+		return;
+	    }
+	    if (slots[i].hash == hash && key_of(slots[i]) == key)
+		throw std::logic_error("Duplicated key in the fields table");
+	}
+    }
+
+public:
+    constexpr explicit FieldTable(const std::array<Field<S>, N>& fields)
+	: fields{fields}, slots{}
+    {
+	for (uint16_t i = 0; i < N; i++)
+	{
+	    insert(fields[i].key, i, false);
+	    if (!fields[i].fallback_key.empty())
+		insert(fields[i].fallback_key, i, true);
+	}
+    }
+
+    constexpr const Field<S>& operator[](const size_t i) const { return fields[i]; }
+
+    constexpr const Slot* find(const std::string_view key, const uint64_t hash) const
+    {
+	for (size_t i = hash & (SLOTS - 1); slots[i].is_used; i = (i + 1) & (SLOTS - 1))
+	    if (slots[i].hash == hash && key_of(slots[i]) == key)
+		return &slots[i];
+	return nullptr;
+    }
+
+    constexpr const Slot* find(const std::string_view key) const
+    {
+	return find(key, str_hash(key));
+    }
+};
+
+/**
+ * It fills a struct with the members of a JSON object, in one pass and in any
+ * order, using the FieldTable given as template parameter (so the lookups are
+ * resolved with the table known at compile time):
+ *
+ *   FieldDecoder<LAP_FIELDS> decoder{};
+ *
+ * A value for a fallback key is only assigned if the value for the key has not
+ * been assigned; and the value for the key always replaces it.
+ *
+ * Call reset() before each object.
+ */
+template <const auto& table>
+class FieldDecoder
+{
+private:
+    using Table = std::remove_cvref_t<decltype(table)>;
+    using S = typename Table::Struct;
+
+    std::bitset<Table::SIZE> assigned{};
+
+public:
+    void reset() { assigned.reset(); }
+
+    /**
+     * It returns false if the key is not in the table, so the caller can
+     * handle it.
+     */
+    bool decode(S& item, const std::string_view key, const uint64_t hash, const JsonScalar& value)
+    {
+	const auto slot = table.find(key, hash);
+	if (slot == nullptr)
+	    return false;
+
+	if (slot->is_fallback)
+	{
+	    if (!assigned[slot->field])
+		table[slot->field].assign(item, value);
+	}
+	else if (table[slot->field].assign(item, value))
+	{
+	    assigned.set(slot->field);
+	}
+	return true;
+    }
+
+    bool decode(S& item, const std::string_view key, const JsonScalar& value)
+    {
+	return decode(item, key, str_hash(key), value);
+    }
+
+    /**
+     * It checks if the field of the key (not a fallback key) was assigned.
+     */
+    bool has(const std::string_view key) const
+    {
+	const auto slot = table.find(key);
+	return slot != nullptr && !slot->is_fallback && assigned[slot->field];
+    }
+};
+
+/*
+ * Fields tables of the data loaded from the API. The fields that depend on
+ * other ones (i.e. positions, which need latitude and longitude) are not here
+ * and they are handled by the loaders.
+ */
+
+inline constexpr FieldTable STEPS_FIELDS{std::array{
+    field<&Steps::datetime_utc, JsonType::String>("datetime_utc"),
+    field<&Steps::datetime_local, JsonType::String>("datetime_local"),
+    field<&Steps::steps, JsonType::Int>("total_steps"),
+    field<&Steps::distance, JsonType::Float>("total_distance"),
+    field<&Steps::calories, JsonType::Int>("total_calories"),
+}};
+
+inline constexpr FieldTable SLEEP_ASSESSMENT_FIELDS{std::array{
+    field<&SleepAssessment::combined_awake_score, JsonType::Int>("combined_awake_score"),
+    field<&SleepAssessment::awake_time_score, JsonType::Int>("awake_time_score"),
+    field<&SleepAssessment::awakenings_count_score, JsonType::Int>("awakenings_count_score"),
+    field<&SleepAssessment::deep_sleep_score, JsonType::Int>("deep_sleep_score"),
+    field<&SleepAssessment::sleep_duration_score, JsonType::Int>("sleep_duration_score"),
+    field<&SleepAssessment::light_sleep_score, JsonType::Int>("light_sleep_score"),
+    field<&SleepAssessment::overall_sleep_score, JsonType::Int>("overall_sleep_score"),
+    field<&SleepAssessment::sleep_quality_score, JsonType::Int>("sleep_quality_score"),
+    field<&SleepAssessment::sleep_recovery_score, JsonType::Int>("sleep_recovery_score"),
+    field<&SleepAssessment::rem_sleep_score, JsonType::Int>("rem_sleep_score"),
+    field<&SleepAssessment::sleep_restlessness_score, JsonType::Int>("sleep_restlessness_score"),
+    field<&SleepAssessment::awakenings_count, JsonType::Int>("awakenings_count"),
+    field<&SleepAssessment::interruptions_score, JsonType::Int>("interruptions_score"),
+    field<&SleepAssessment::average_stress_during_sleep, JsonType::Float>("average_stress_during_sleep"),
+}};
+
+// Members of the activity object.
+inline constexpr FieldTable ACTIVITY_FIELDS{std::array{
+    field<&Activity::id, JsonType::String>("id"),
+    field<&Activity::zone_info, JsonType::String>("zone_info"),
+    field<&Activity::username, JsonType::String>("username"),
+}};
+
+// Members of the session object of the activity.
+inline constexpr FieldTable ACTIVITY_SESSION_FIELDS{std::array{
+    field<&Activity::sport_profile_name, JsonType::String>("sport_profile_name"),
+    field<&Activity::sport, JsonType::String>("sport"),
+    field<&Activity::sub_sport, JsonType::String>("sub_sport"),
+    field<&Activity::start_time_utc, JsonType::String>("start_time"),
+    field<&Activity::total_elapsed_time, JsonType::Number>("total_elapsed_time"),
+    field<&Activity::total_timer_time, JsonType::Number>("total_timer_time"),
+    field<&Activity::total_distance, JsonType::Number>("total_distance"),
+    field<&Activity::avg_speed, JsonType::Number>("enhanced_avg_speed", "avg_speed"),
+    field<&Activity::max_speed, JsonType::Number>("enhanced_max_speed", "max_speed"),
+    field<&Activity::avg_cadence, JsonType::Number>("avg_cadence"),
+    field<&Activity::max_cadence, JsonType::Number>("max_cadence"),
+    field<&Activity::avg_running_cadence, JsonType::Number>("avg_running_cadence"),
+    field<&Activity::max_running_cadence, JsonType::Number>("max_running_cadence"),
+    field<&Activity::total_strides, JsonType::Number>("total_strides"),
+    field<&Activity::total_calories, JsonType::Number>("total_calories"),
+    field<&Activity::total_ascent, JsonType::Number>("total_ascent"),
+    field<&Activity::total_descent, JsonType::Number>("total_descent"),
+    field<&Activity::avg_temperature, JsonType::Number>("avg_temperature"),
+    field<&Activity::max_temperature, JsonType::Number>("max_temperature"),
+    field<&Activity::min_temperature, JsonType::Number>("min_temperature"),
+    field<&Activity::avg_respiration_rate, JsonType::Number>("enhanced_avg_respiration_rate"),
+    field<&Activity::max_respiration_rate, JsonType::Number>("enhanced_max_respiration_rate"),
+    field<&Activity::min_respiration_rate, JsonType::Number>("enhanced_min_respiration_rate"),
+    field<&Activity::training_load_peak, JsonType::Number>("training_load_peak"),
+    field<&Activity::total_training_effect, JsonType::Number>("total_training_effect"),
+    field<&Activity::total_anaerobic_training_effect, JsonType::Number>(
+	"total_anaerobic_training_effect"),
+}};
+
+inline constexpr FieldTable SPLIT_FIELDS{std::array{
+    field<&Split::split_type, JsonType::String>("split_type"),
+    field<&Split::total_elapsed_time, JsonType::Float>("total_elapsed_time"),
+    field<&Split::total_timer_time, JsonType::Float>("total_timer_time"),
+    field<&Split::start_time, JsonType::Float>("start_time"),
+    field<&Split::avg_hr, JsonType::Int>("avg_hr"),
+    field<&Split::max_hr, JsonType::Int>("max_hr"),
+    field<&Split::total_calories, JsonType::Int>("total_calories"),
+    field<&Split::difficulty, JsonType::Int>("difficulty"),
+}};
+
+inline constexpr FieldTable SET_FIELDS{std::array{
+    field<&Set::timestamp, JsonType::String>("timestamp"),
+    field<&Set::duration, JsonType::Float>("duration"),
+    field<&Set::repetitions, JsonType::Int>("repetitions"),
+    field<&Set::weight, JsonType::Float>("weight"),
+    field<&Set::start_time, JsonType::String>("start_time"),
+    field<&Set::weight_display_unit, JsonType::String>("weight_display_unit"),
+    field<&Set::message_index, JsonType::Int>("message_index"),
+    field<&Set::wkt_step_index, JsonType::Int>("wkt_step_index"),
+}};
+
+inline constexpr FieldTable LAP_FIELDS{std::array{
+    field<&Lap::message_index, JsonType::Int>("message_index"),
+    field<&Lap::timestamp, JsonType::String>("timestamp"),
+    field<&Lap::start_time, JsonType::String>("start_time"),
+    field<&Lap::total_elapsed_time, JsonType::Float>("total_elapsed_time"),
+    field<&Lap::total_timer_time, JsonType::Float>("total_timer_time"),
+    field<&Lap::total_moving_time, JsonType::Float>("total_moving_time"),
+    field<&Lap::total_distance, JsonType::Float>("total_distance"),
+    field<&Lap::avg_speed, JsonType::Float>("enhanced_avg_speed", "avg_speed"),
+    field<&Lap::max_speed, JsonType::Float>("enhanced_max_speed", "max_speed"),
+    field<&Lap::avg_heart_rate, JsonType::Int>("avg_heart_rate"),
+    field<&Lap::max_heart_rate, JsonType::Int>("max_heart_rate"),
+    field<&Lap::min_heart_rate, JsonType::Int>("min_heart_rate"),
+    field<&Lap::avg_cadence, JsonType::Int>("avg_cadence"),
+    field<&Lap::max_cadence, JsonType::Int>("max_cadence"),
+    field<&Lap::avg_running_cadence, JsonType::Int>("avg_running_cadence"),
+    field<&Lap::max_running_cadence, JsonType::Int>("max_running_cadence"),
+    field<&Lap::total_ascent, JsonType::Int>("total_ascent"),
+    field<&Lap::total_descent, JsonType::Int>("total_descent"),
+    field<&Lap::avg_altitude, JsonType::Number>("enhanced_avg_altitude", "avg_altitude"),
+    field<&Lap::max_altitude, JsonType::Number>("enhanced_max_altitude", "max_altitude"),
+    field<&Lap::min_altitude, JsonType::Number>("enhanced_min_altitude", "min_altitude"),
+    field<&Lap::avg_grade, JsonType::Number>("avg_grade"),
+    field<&Lap::avg_pos_grade, JsonType::Number>("avg_pos_grade"),
+    field<&Lap::avg_neg_grade, JsonType::Number>("avg_neg_grade"),
+    field<&Lap::max_pos_grade, JsonType::Number>("max_pos_grade"),
+    field<&Lap::max_neg_grade, JsonType::Number>("max_neg_grade"),
+    field<&Lap::total_strides, JsonType::Int>("total_strides"),
+    field<&Lap::total_calories, JsonType::Int>("total_calories"),
+    field<&Lap::total_fat_calories, JsonType::Int>("total_fat_calories"),
+    field<&Lap::avg_temperature, JsonType::Number>("avg_temperature"),
+    field<&Lap::max_temperature, JsonType::Number>("max_temperature"),
+    field<&Lap::min_temperature, JsonType::Number>("min_temperature"),
+    field<&Lap::avg_respiration_rate, JsonType::Number>(
+	"enhanced_avg_respiration_rate", "avg_respiration_rate"),
+    field<&Lap::max_respiration_rate, JsonType::Number>(
+	"enhanced_max_respiration_rate", "max_respiration_rate"),
+}};
+
+inline constexpr FieldTable RECORD_FIELDS{std::array{
+    field<&Record::timestamp, JsonType::Number>("timestamp"),
+    field<&Record::distance, JsonType::Number>("distance"),
+    field<&Record::speed, JsonType::Number>("enhanced_speed", "speed"),
+    field<&Record::heart_rate, JsonType::Int>("heart_rate"),
+    field<&Record::power, JsonType::Int>("power"),
+    field<&Record::cadence, JsonType::Int>("cadence"),
+    field<&Record::altitude, JsonType::Number>("enhanced_altitude", "altitude"),
+}};
+
+} // namespace fitgalgo
+
+#endif // _ES_RGMF_CORE_FIELDS_H
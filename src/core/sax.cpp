@@ -0,0 +1,1126 @@
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string_view>
+
+#include <rapidjson/memorystream.h>
+#include <rapidjson/reader.h>
+
+#include "fields.h"
+#include "sax.h"
+#include "../utils/date.h"
+#include "../utils/parallel.h"
+
+namespace fitgalgo
+{
+
+namespace
+{
+
+/**
+ * Base of the SAX handlers given to rapidjson::Reader.
+ *
+ * It converts the events of the reader into calls to the derived handler:
+ * - start_object() and start_array(): return false to skip the whole value.
+ * - end_object() and end_array(): only for the values not skipped.
+ * - value(scalar): the scalar values. The key of the object member is in
+ *   key (and its str_hash in key_hash, to switch on it); inside arrays the
+ *   derived handler knows it by its state.
+ */
+template <typename Derived>
+class Handler
+{
+private:
+    size_t skip_depth{};
+
+    Derived& derived() { return static_cast<Derived&>(*this); }
+
+    bool scalar(const JsonScalar& value)
+    {
+	if (skip_depth == 0)
+	    derived().value(value);
+	return true;
+    }
+
+protected:
+    std::string key{};
+    uint64_t key_hash{};
+
+public:
+    bool Null() { return scalar({}); }
+    bool Bool(bool b) { return scalar({.kind = JsonScalar::Kind::Bool, .boolean = b}); }
+    bool Int(int i) { return scalar({.kind = JsonScalar::Kind::Int, .integer = i}); }
+    bool Uint(unsigned u) { return scalar({.kind = JsonScalar::Kind::Int, .integer = u}); }
+    bool Int64(int64_t i) { return scalar({.kind = JsonScalar::Kind::Int, .integer = i}); }
+    bool Uint64(uint64_t u)
+    {
+	if (u > static_cast<uint64_t>(INT64_MAX))
+	    return scalar({.kind = JsonScalar::Kind::Double, .number = static_cast<double>(u)});
+	return scalar({.kind = JsonScalar::Kind::Int, .integer = static_cast<int64_t>(u)});
+    }
+    bool Double(double d) { return scalar({.kind = JsonScalar::Kind::Double, .number = d}); }
+    bool RawNumber(const char* str, rapidjson::SizeType length, bool)
+    {
+	return scalar({.kind = JsonScalar::Kind::String, .string = std::string_view(str, length)});
+    }
+    bool String(const char* str, rapidjson::SizeType length, bool)
+    {
+	return scalar({.kind = JsonScalar::Kind::String, .string = std::string_view(str, length)});
+    }
+
+    bool Key(const char* str, rapidjson::SizeType length, bool)
+    {
+	if (skip_depth == 0)
+	{
+	    key.assign(str, length);
+	    key_hash = str_hash(key);
+	}
+	return true;
+    }
+
+    bool StartObject()
+    {
+	if (skip_depth > 0 || !derived().start_object())
+	    skip_depth++;
+	return true;
+    }
+
+    bool EndObject(rapidjson::SizeType)
+    {
+	if (skip_depth > 0)
+	    skip_depth--;
+	else
+	    derived().end_object();
+	return true;
+    }
+
+    bool StartArray()
+    {
+	if (skip_depth > 0 || !derived().start_array())
+	    skip_depth++;
+	return true;
+    }
+
+    bool EndArray(rapidjson::SizeType)
+    {
+	if (skip_depth > 0)
+	    skip_depth--;
+	else
+	    derived().end_array();
+	return true;
+    }
+};
+
+class StepsHandler : public Handler<StepsHandler>
+{
+private:
+    enum class State { Start, Root, Data, Item, End };
+
+    StepsData& data;
+    State state{State::Start};
+    bool has_data{};
+    Steps item{};
+    FieldDecoder<STEPS_FIELDS> fields{};
+
+    void add_error()
+    {
+	data.errors.emplace_back(
+	    "JSON error: a datetime_local item is not an object, not exists or is not valid");
+    }
+
+public:
+    explicit StepsHandler(StepsData& data) : data{data} {}
+
+    bool is_valid() const { return has_data; }
+
+    bool start_object()
+    {
+	switch (state)
+	{
+	case State::Start:
+	    state = State::Root;
+	    return true;
+	case State::Data:
+	    state = State::Item;
+	    item = Steps{};
+	    fields.reset();
+	    return true;
+	default:
+	    return false;
+	}
+    }
+
+    void end_object()
+    {
+	if (state == State::Item)
+	{
+	    DateIdx idx{item.datetime_local};
+	    if (idx.is_valid())
+		data.steps[idx] = std::move(item);
+	    else
+		add_error();
+	    state = State::Data;
+	}
+	else if (state == State::Root)
+	{
+	    state = State::End;
+	}
+    }
+
+    bool start_array()
+    {
+	if (state == State::Root && key == "data")
+	{
+	    state = State::Data;
+	    has_data = true;
+	    return true;
+	}
+	if (state == State::Data)
+	    add_error();
+	return false;
+    }
+
+    void end_array()
+    {
+	if (state == State::Data)
+	    state = State::Root;
+    }
+
+    void value(const JsonScalar& v)
+    {
+	if (state == State::Data)
+	{
+	    add_error();
+	}
+	else if (state == State::Item)
+	{
+	    fields.decode(item, key, key_hash, v);
+	}
+    }
+};
+
+class SleepHandler : public Handler<SleepHandler>
+{
+private:
+    enum class State { Start, Root, Data, Item, Assessment, Levels, Level, Dates, End };
+
+    SleepData& data;
+    State state{State::Start};
+    bool has_data{};
+    Sleep item{};
+    FieldDecoder<SLEEP_ASSESSMENT_FIELDS> assessment_fields{};
+    SleepLevel level{};
+    bool has_level_time{};
+
+    void add_error()
+    {
+	data.errors.emplace_back("JSON error: it expects an object with sleep information.");
+    }
+
+    void level_value(const JsonScalar& v)
+    {
+	if (!v.is_string())
+	    return;
+
+	switch (key_hash)
+	{
+	case str_hash("datetime_utc"):
+	    if (key == "datetime_utc")
+	    {
+		const auto timestamp = from_isodatetime_to_epoch(v.string);
+		has_level_time = timestamp.has_value();
+		level.timestamp = timestamp.value_or(0);
+	    }
+	    break;
+	case str_hash("level"):
+	    if (key == "level")
+		level.stage = to_sleep_stage(v.string);
+	    break;
+	}
+    }
+
+    static SleepStage to_sleep_stage(const std::string_view name)
+    {
+	auto it = std::find(std::begin(sleep_stage_names), std::end(sleep_stage_names), name);
+	if (it != std::end(sleep_stage_names))
+	    return SleepStage(std::distance(std::begin(sleep_stage_names), it));
+	return SleepStage::UNMEASURABLE;
+    }
+
+public:
+    explicit SleepHandler(SleepData& data) : data{data} {}
+
+    bool is_valid() const { return has_data; }
+
+    bool start_object()
+    {
+	switch (state)
+	{
+	case State::Start:
+	    state = State::Root;
+	    return true;
+	case State::Data:
+	    state = State::Item;
+	    item = Sleep{};
+	    return true;
+	case State::Item:
+	    if (key != "assessment")
+		return false;
+	    state = State::Assessment;
+	    item.assessment = SleepAssessment{};
+	    assessment_fields.reset();
+	    return true;
+	case State::Levels:
+	    state = State::Level;
+	    level = SleepLevel{};
+	    has_level_time = false;
+	    return true;
+	default:
+	    return false;
+	}
+    }
+
+    void end_object()
+    {
+	switch (state)
+	{
+	case State::Root:
+	    state = State::End;
+	    break;
+	case State::Item:
+	{
+	    auto idx1 = item.dates.size() == 2 ? DateIdx(item.dates[0]) : DateIdx();
+	    auto idx2 = item.dates.size() == 2 ? DateIdx(item.dates[1]) : DateIdx();
+	    if (idx1.is_valid() && idx2.is_valid())
+		data.sleep[idx1] = std::move(item);
+	    else
+		data.errors.emplace_back("JSON error: dates are no valid or are not dates.");
+	    state = State::Data;
+	    break;
+	}
+	case State::Assessment:
+	    state = State::Item;
+	    break;
+	case State::Level:
+	    // Levels without a valid time are discarded.
+	    if (has_level_time)
+		item.levels.emplace_back(level);
+	    state = State::Levels;
+	    break;
+	default:
+	    break;
+	}
+    }
+
+    bool start_array()
+    {
+	switch (state)
+	{
+	case State::Root:
+	    if (key != "data")
+		return false;
+	    state = State::Data;
+	    has_data = true;
+	    return true;
+	case State::Data:
+	    add_error();
+	    return false;
+	case State::Item:
+	    if (key == "levels")
+	    {
+		state = State::Levels;
+		item.levels.clear();
+		return true;
+	    }
+	    if (key == "dates")
+	    {
+		state = State::Dates;
+		item.dates.clear();
+		return true;
+	    }
+	    return false;
+	default:
+	    return false;
+	}
+    }
+
+    void end_array()
+    {
+	if (state == State::Data)
+	    state = State::Root;
+	else if (state == State::Levels || state == State::Dates)
+	    state = State::Item;
+    }
+
+    void value(const JsonScalar& v)
+    {
+	switch (state)
+	{
+	case State::Data:
+	    add_error();
+	    break;
+	case State::Item:
+	    if (key == "zone_info" && v.is_string())
+		item.zone_info = Symbol(v.string);
+	    break;
+	case State::Assessment:
+	    assessment_fields.decode(item.assessment, key, key_hash, v);
+	    break;
+	case State::Level:
+	    level_value(v);
+	    break;
+	case State::Dates:
+	    if (v.is_string())
+		item.dates.emplace_back(v.get_string());
+	    break;
+	default:
+	    break;
+	}
+    }
+};
+
+class ActivitiesHandler : public Handler<ActivitiesHandler>
+{
+private:
+    enum class State {
+	Start, Root, Data, Item, Session, Splits, Split, Sets, Set,
+	SetCategory, SetCategorySubtype, End
+    };
+
+    /**
+     * Values of the activity that depend on other values of the same object,
+     * which could come in any order. They are resolved when the object ends.
+     */
+    struct Pending
+    {
+	bool has_splits{};
+	bool has_sets{};
+	float splits_work_time{};
+	float sets_work_time{};
+
+	std::optional<float> start_lat{};
+	std::optional<float> start_lon{};
+	std::optional<float> end_lat{};
+	std::optional<float> end_lon{};
+
+	bool split_discarded{};
+	int split_result{};
+    };
+
+    ActivitiesData& data;
+    State state{State::Start};
+    bool has_data{};
+    Activity activity{};
+    std::vector<Split> splits{};
+    std::vector<Set> sets{};
+    Pending pending{};
+    FieldDecoder<ACTIVITY_FIELDS> activity_fields{};
+    FieldDecoder<ACTIVITY_SESSION_FIELDS> session_fields{};
+    FieldDecoder<SPLIT_FIELDS> split_fields{};
+    FieldDecoder<SET_FIELDS> set_fields{};
+
+    void add_error()
+    {
+	data.errors.emplace_back("JSON error: it expects an object with activity information.");
+    }
+
+    void start_item()
+    {
+	activity = Activity{};
+	splits.clear();
+	sets.clear();
+	pending = Pending{};
+	activity_fields.reset();
+    }
+
+    void end_item()
+    {
+	std::optional<float> work_time{};
+	if (pending.has_splits && pending.splits_work_time > 0)
+	    work_time = pending.splits_work_time;
+	else if (!pending.has_splits && pending.has_sets && pending.sets_work_time > 0)
+	    work_time = pending.sets_work_time;
+	activity.total_work_time = work_time.has_value() ? work_time : activity.total_timer_time;
+
+	DateIdx idx{activity.start_time_utc};
+	if (!idx.is_valid())
+	{
+	    data.errors.emplace_back("JSON error: start time is not a valid date.");
+	    return;
+	}
+
+	if (pending.has_splits)
+	{
+	    SplitsActivity item{std::move(activity)};
+	    item.splits = std::move(splits);
+	    data.activities[idx] = std::move(item);
+	}
+	else if (pending.has_sets)
+	{
+	    SetsActivity item{std::move(activity)};
+	    item.sets = std::move(sets);
+	    data.activities[idx] = std::move(item);
+	}
+	else
+	{
+	    data.activities[idx] = DistanceActivity{std::move(activity)};
+	}
+    }
+
+    void end_session()
+    {
+	if (pending.start_lat.has_value() && pending.start_lon.has_value())
+	    activity.start_lat_lon = {pending.start_lat.value(), pending.start_lon.value()};
+	if (pending.end_lat.has_value() && pending.end_lon.has_value())
+	    activity.end_lat_lon = {pending.end_lat.value(), pending.end_lon.value()};
+    }
+
+    void end_split()
+    {
+	auto& split = splits.back();
+	if (pending.split_discarded)
+	    split.result = SplitResult::DISCARDED;
+	if (pending.split_result == 2)
+	    split.result = SplitResult::ATTEMPTED;
+	else if (pending.split_result == 3)
+	    split.result = SplitResult::COMPLETED;
+	if (split_fields.has("total_timer_time") &&
+	    (split.result == SplitResult::ATTEMPTED || split.result == SplitResult::COMPLETED))
+	    pending.splits_work_time += split.total_timer_time;
+    }
+
+    void end_set()
+    {
+	const auto& set = sets.back();
+	if (set_fields.has("duration") && set.set_type == SetType::ACTIVE)
+	    pending.sets_work_time += set.duration;
+    }
+
+    void item_value(const JsonScalar& v)
+    {
+	activity_fields.decode(activity, key, key_hash, v);
+    }
+
+    void session_value(const JsonScalar& v)
+    {
+	if (session_fields.decode(activity, key, key_hash, v) || !v.is_number())
+	    return;
+
+	switch (key_hash)
+	{
+	case str_hash("start_position_lat"):
+	    if (key == "start_position_lat")
+		pending.start_lat = v.get_float();
+	    break;
+	case str_hash("start_position_lon"):
+	    if (key == "start_position_lon")
+		pending.start_lon = v.get_float();
+	    break;
+	case str_hash("end_position_lat"):
+	    if (key == "end_position_lat")
+		pending.end_lat = v.get_float();
+	    break;
+	case str_hash("end_position_lon"):
+	    if (key == "end_position_lon")
+		pending.end_lon = v.get_float();
+	    break;
+	}
+    }
+
+    void split_value(const JsonScalar& v)
+    {
+	if (split_fields.decode(splits.back(), key, key_hash, v) || !v.is_int())
+	    return;
+
+	if (key == "result")
+	    pending.split_result = v.get_int();
+	else if (key == "discarded")
+	    pending.split_discarded = true;
+    }
+
+    void set_value(const JsonScalar& v)
+    {
+	auto& set = sets.back();
+	if (!set_fields.decode(set, key, key_hash, v) && key == "set_type" && v.is_string())
+	    set.set_type = to_set_type(v.string);
+    }
+
+    static SetType to_set_type(const std::string_view name)
+    {
+	auto it = std::find(std::begin(set_type_names), std::end(set_type_names), name);
+	if (it != std::end(set_type_names))
+	    return SetType(std::distance(std::begin(set_type_names), it));
+	return SetType::UNKNOWN;
+    }
+
+    static void category_value(const JsonScalar& v, std::vector<Symbol>& category)
+    {
+	if (v.is_int())
+	    category.emplace_back(std::to_string(v.get_int()));
+	else if (v.is_string())
+	    category.emplace_back(v.string);
+    }
+
+public:
+    /**
+     * If is_element, the handler parses the elements of the data array one by
+     * one (see parse_parallel).
+     */
+    explicit ActivitiesHandler(ActivitiesData& data, const bool is_element = false)
+	: data{data},
+	  state{is_element ? State::Data : State::Start},
+	  has_data{is_element} {}
+
+    bool is_valid() const { return has_data; }
+
+    bool start_object()
+    {
+	switch (state)
+	{
+	case State::Start:
+	    state = State::Root;
+	    return true;
+	case State::Data:
+	    state = State::Item;
+	    start_item();
+	    return true;
+	case State::Item:
+	    if (key != "session")
+		return false;
+	    state = State::Session;
+	    session_fields.reset();
+	    return true;
+	case State::Splits:
+	    state = State::Split;
+	    splits.emplace_back();
+	    pending.split_discarded = false;
+	    pending.split_result = 0;
+	    split_fields.reset();
+	    return true;
+	case State::Sets:
+	    state = State::Set;
+	    sets.emplace_back();
+	    set_fields.reset();
+	    return true;
+	default:
+	    return false;
+	}
+    }
+
+    void end_object()
+    {
+	switch (state)
+	{
+	case State::Root:
+	    state = State::End;
+	    break;
+	case State::Item:
+	    end_item();
+	    state = State::Data;
+	    break;
+	case State::Session:
+	    end_session();
+	    state = State::Item;
+	    break;
+	case State::Split:
+	    end_split();
+	    state = State::Splits;
+	    break;
+	case State::Set:
+	    end_set();
+	    state = State::Sets;
+	    break;
+	default:
+	    break;
+	}
+    }
+
+    bool start_array()
+    {
+	switch (state)
+	{
+	case State::Root:
+	    if (key != "data")
+		return false;
+	    state = State::Data;
+	    has_data = true;
+	    return true;
+	case State::Data:
+	    add_error();
+	    return false;
+	case State::Item:
+	    if (key == "splits")
+	    {
+		state = State::Splits;
+		pending.has_splits = true;
+		return true;
+	    }
+	    if (key == "sets")
+	    {
+		state = State::Sets;
+		pending.has_sets = true;
+		return true;
+	    }
+	    return false;
+	case State::Set:
+	    if (key == "category")
+	    {
+		state = State::SetCategory;
+		return true;
+	    }
+	    if (key == "category_subtype")
+	    {
+		state = State::SetCategorySubtype;
+		return true;
+	    }
+	    return false;
+	default:
+	    return false;
+	}
+    }
+
+    void end_array()
+    {
+	switch (state)
+	{
+	case State::Data:
+	    state = State::Root;
+	    break;
+	case State::Splits:
+	case State::Sets:
+	    state = State::Item;
+	    break;
+	case State::SetCategory:
+	case State::SetCategorySubtype:
+	    state = State::Set;
+	    break;
+	default:
+	    break;
+	}
+    }
+
+    void value(const JsonScalar& v)
+    {
+	switch (state)
+	{
+	case State::Data:
+	    add_error();
+	    break;
+	case State::Item:
+	    item_value(v);
+	    break;
+	case State::Session:
+	    session_value(v);
+	    break;
+	case State::Split:
+	    split_value(v);
+	    break;
+	case State::Set:
+	    set_value(v);
+	    break;
+	case State::SetCategory:
+	    category_value(v, sets.back().category);
+	    break;
+	case State::SetCategorySubtype:
+	    category_value(v, sets.back().category_subtype);
+	    break;
+	default:
+	    break;
+	}
+    }
+};
+
+class RecordsHandler : public Handler<RecordsHandler>
+{
+private:
+    enum class State { Start, Root, Data, Item, End };
+
+    RecordsData& data;
+    State state{State::Start};
+    bool has_data{};
+    Record item{};
+    std::optional<int> lat{}, lon{};
+    FieldDecoder<RECORD_FIELDS> fields{};
+
+    void add_error()
+    {
+	data.errors.emplace_back("JSON error: a record is not an object.");
+    }
+
+public:
+    explicit RecordsHandler(RecordsData& data) : data{data} {}
+
+    bool is_valid() const { return has_data; }
+
+    bool start_object()
+    {
+	switch (state)
+	{
+	case State::Start:
+	    state = State::Root;
+	    return true;
+	case State::Data:
+	    state = State::Item;
+	    item = Record{};
+	    lat.reset();
+	    lon.reset();
+	    fields.reset();
+	    return true;
+	default:
+	    return false;
+	}
+    }
+
+    void end_object()
+    {
+	if (state == State::Item)
+	{
+	    if (lat.has_value() && lon.has_value())
+		item.position_lat_lon = {lat.value(), lon.value()};
+	    data.records.push_back(item);
+	    state = State::Data;
+	}
+	else if (state == State::Root)
+	{
+	    state = State::End;
+	}
+    }
+
+    bool start_array()
+    {
+	if (state == State::Root && key == "data")
+	{
+	    state = State::Data;
+	    has_data = true;
+	    return true;
+	}
+	if (state == State::Data)
+	    add_error();
+	return false;
+    }
+
+    void end_array()
+    {
+	if (state == State::Data)
+	    state = State::Root;
+    }
+
+    void value(const JsonScalar& v)
+    {
+	if (state == State::Data)
+	{
+	    add_error();
+	}
+	else if (state == State::Item && !fields.decode(item, key, key_hash, v) && v.is_int())
+	{
+	    switch (key_hash)
+	    {
+	    case str_hash("position_lat"):
+		if (key == "position_lat")
+		    lat = v.get_int();
+		break;
+	    case str_hash("position_long"):
+		if (key == "position_long")
+		    lon = v.get_int();
+		break;
+	    }
+	}
+    }
+};
+
+template <typename Stream, typename H>
+bool parse_with(Stream& stream, H& handler)
+{
+    rapidjson::Reader reader;
+    return !reader.Parse(stream, handler).IsError() && handler.is_valid();
+}
+
+template <typename H, typename T>
+bool parse_string(const std::string& json, T& data)
+{
+    H handler{data};
+    rapidjson::StringStream stream(json.c_str());
+    return parse_with(stream, handler);
+}
+
+size_t skip_spaces(const std::string_view json, size_t i)
+{
+    while (i < json.size() && (json[i] == ' ' || json[i] == '\t' || json[i] == '\n' || json[i] == '\r'))
+	i++;
+    return i;
+}
+
+// json[i] is '"'. It returns the position after the closing '"'.
+size_t skip_string(const std::string_view json, size_t i)
+{
+    for (i++; i < json.size(); i++)
+    {
+	if (json[i] == '\\')
+	    i++;
+	else if (json[i] == '"')
+	    return i + 1;
+    }
+    return std::string_view::npos;
+}
+
+// It returns the position after the value that starts at i.
+size_t skip_value(const std::string_view json, size_t i)
+{
+    if (i >= json.size())
+	return std::string_view::npos;
+
+    if (json[i] == '"')
+	return skip_string(json, i);
+
+    if (json[i] != '{' && json[i] != '[')
+    {
+	while (i < json.size() && std::strchr(",]} \t\n\r", json[i]) == nullptr)
+	    i++;
+	return i;
+    }
+
+    size_t depth = 0;
+    while (i < json.size())
+    {
+	const char c = json[i];
+	if (c == '"')
+	{
+	    i = skip_string(json, i);
+	    if (i == std::string_view::npos)
+		return i;
+	    continue;
+	}
+
+	if (c == '{' || c == '[')
+	{
+	    depth++;
+	}
+	else if (c == '}' || c == ']')
+	{
+	    depth--;
+	    if (depth == 0)
+		return i + 1;
+	}
+	i++;
+    }
+    return std::string_view::npos;
+}
+
+/**
+ * The data array of a JSON object: the elements and the bounds of the array in
+ * the JSON, from its '[' to after its ']'.
+ */
+struct DataArray
+{
+    std::vector<std::string_view> elements{};
+    size_t begin{};
+    size_t end{};
+};
+
+// json[i] is '['. It returns the position after the closing ']'.
+size_t array_elements(const std::string_view json, size_t i, std::vector<std::string_view>& elements)
+{
+    i = skip_spaces(json, i + 1);
+    if (i < json.size() && json[i] == ']')
+	return i + 1;
+
+    while (true)
+    {
+	const size_t begin = i;
+	i = skip_value(json, i);
+	if (i == std::string_view::npos || i == begin)
+	    return std::string_view::npos;
+	elements.emplace_back(json.substr(begin, i - begin));
+
+	i = skip_spaces(json, i);
+	if (i < json.size() && json[i] == ']')
+	    return i + 1;
+	if (i >= json.size() || json[i] != ',')
+	    return std::string_view::npos;
+	i = skip_spaces(json, i + 1);
+    }
+}
+
+/**
+ * The data array of the JSON object, found without parsing it: only strings
+ * and brackets are followed. It returns nothing if the JSON has not that
+ * structure.
+ *
+ * The scan does not validate the JSON: every element and the rest of the
+ * object are parsed later by rapidjson (see parse_parallel).
+ */
+std::optional<DataArray> data_array(const std::string_view json)
+{
+    size_t i = skip_spaces(json, 0);
+    if (i >= json.size() || json[i] != '{')
+	return std::nullopt;
+
+    for (i++; ; i++)
+    {
+	i = skip_spaces(json, i);
+	if (i >= json.size() || json[i] != '"')
+	    return std::nullopt;
+
+	const size_t key_begin = i + 1;
+	i = skip_string(json, i);
+	if (i == std::string_view::npos)
+	    return std::nullopt;
+	const auto key = json.substr(key_begin, i - 1 - key_begin);
+
+	i = skip_spaces(json, i);
+	if (i >= json.size() || json[i] != ':')
+	    return std::nullopt;
+	i = skip_spaces(json, i + 1);
+
+	if (key == "data" && i < json.size() && json[i] == '[')
+	{
+	    DataArray array{.begin = i};
+	    array.end = array_elements(json, i, array.elements);
+	    if (array.end == std::string_view::npos)
+		return std::nullopt;
+	    return array;
+	}
+
+	i = skip_value(json, i);
+	if (i == std::string_view::npos)
+	    return std::nullopt;
+	i = skip_spaces(json, i);
+	if (i >= json.size() || json[i] != ',')
+	    return std::nullopt;
+    }
+}
+
+/**
+ * It parses a big dataset in several threads.
+ *
+ * The JSON without the elements of the data array (the skeleton) is parsed
+ * sequentially into data, so everything outside the array is validated as in
+ * a sequential parse. The elements are split in contiguous groups of similar
+ * size and every group is parsed by a worker into its own dataset, a sorted
+ * run. Then, the runs (and the records already in data) are merged moving
+ * their items. They are merged from the last one so, as in a sequential
+ * parse, the last record of an index wins.
+ *
+ * It returns nothing if the data array is not found, so the JSON has to be
+ * parsed sequentially.
+ */
+template <typename H, typename T, auto records>
+std::optional<bool> parse_parallel(const std::string& json, T& data)
+{
+    const auto array = data_array(json);
+    if (!array.has_value())
+	return std::nullopt;
+    const auto& elements = array->elements;
+
+    std::string skeleton{};
+    skeleton.reserve(json.size() - (array->end - array->begin) + 2);
+    skeleton.append(json, 0, array->begin).append("[]").append(json, array->end);
+    if (!parse_string<H>(skeleton, data))
+	return false;
+
+    const size_t workers = std::clamp<size_t>(
+	std::thread::hardware_concurrency(), 1, std::max<size_t>(elements.size(), 1));
+
+    // Groups by size in bytes: group g ends at bounds[g + 1].
+    std::vector<size_t> bounds{0};
+    const size_t group_size = (array->end - array->begin) / workers + 1;
+    size_t group_bytes = 0;
+    for (size_t i = 0; i < elements.size(); i++)
+    {
+	group_bytes += elements[i].size();
+	if (group_bytes >= group_size && bounds.size() < workers)
+	{
+	    bounds.emplace_back(i + 1);
+	    group_bytes = 0;
+	}
+    }
+    if (bounds.back() != elements.size())
+	bounds.emplace_back(elements.size());
+
+    const size_t groups = bounds.size() - 1;
+    std::vector<T> runs(groups);
+    std::vector<char> valid(groups, false);
+    parallel_for(groups, workers, [&](const size_t g) {
+	H handler{runs[g], true};
+	rapidjson::Reader reader;
+	valid[g] = true;
+	for (size_t i = bounds[g]; i < bounds[g + 1] && valid[g]; i++)
+	{
+	    rapidjson::MemoryStream stream(elements[i].data(), elements[i].size());
+	    valid[g] = !reader.Parse(stream, handler).IsError();
+	}
+    });
+
+    if (std::find(valid.cbegin(), valid.cend(), false) != valid.cend())
+	return false;
+
+    T merged{};
+    for (size_t g = groups; g-- > 0; )
+	(merged.*records).merge(std::move(runs[g].*records));
+    (merged.*records).merge(std::move(data.*records));
+    data.*records = std::move(merged.*records);
+
+    for (const auto& run : runs)
+	data.errors.insert(data.errors.end(), run.errors.cbegin(), run.errors.cend());
+
+    return true;
+}
+
+template <typename H, typename T>
+bool parse_chunks(ChunkStream& stream, T& data)
+{
+    H handler{data};
+    const bool is_valid = parse_with(stream, handler);
+    stream.finish();
+    return is_valid;
+}
+
+} // namespace
+
+bool parse_json(const std::string& json, StepsData& data)
+{
+    return parse_string<StepsHandler>(json, data);
+}
+
+bool parse_json(const std::string& json, SleepData& data)
+{
+    return parse_string<SleepHandler>(json, data);
+}
+
+bool parse_json(const std::string& json, ActivitiesData& data)
+{
+    if (json.size() >= PARALLEL_PARSE_MIN_SIZE && std::thread::hardware_concurrency() > 1)
+	return parse_json_parallel(json, data);
+    return parse_string<ActivitiesHandler>(json, data);
+}
+
+bool parse_json_parallel(const std::string& json, ActivitiesData& data)
+{
+    const auto is_valid =
+	parse_parallel<ActivitiesHandler, ActivitiesData, &ActivitiesData::activities>(json, data);
+    return is_valid.has_value() ? is_valid.value() : parse_string<ActivitiesHandler>(json, data);
+}
+
+bool parse_json(const std::string& json, RecordsData& data)
+{
+    return parse_string<RecordsHandler>(json, data);
+}
+
+bool parse_json(ChunkStream& stream, StepsData& data)
+{
+    return parse_chunks<StepsHandler>(stream, data);
+}
+
+bool parse_json(ChunkStream& stream, SleepData& data)
+{
+    return parse_chunks<SleepHandler>(stream, data);
+}
+
+bool parse_json(ChunkStream& stream, ActivitiesData& data)
+{
+    return parse_chunks<ActivitiesHandler>(stream, data);
+}
+
+} // namespace fitgalgo
@@ -0,0 +1,54 @@
+#ifndef _ES_RGMF_CORE_SAX_H
+#define _ES_RGMF_CORE_SAX_H 1
+
+#include <string>
+
+#include "api.h"
+#include "../utils/chunk_stream.h"
+
+namespace fitgalgo
+{
+
+// Activities bigger than this are parsed in several threads.
+constexpr const size_t PARALLEL_PARSE_MIN_SIZE = 1024 * 1024;
+
+// Datasets whose full downloads are buffered to be parsed in several threads
+// instead of being streamed (see Connection::get_dataset).
+template <typename T>
+constexpr bool HAS_PARALLEL_PARSE = false;
+template <>
+inline constexpr bool HAS_PARALLEL_PARSE<ActivitiesData> = true;
+
+/**
+ * SAX parsers of the datasets.
+ *
+ * Datasets can be huge (years of history) so they are not loaded from a
+ * rapidjson::Document: the records are filled while the tokens of the JSON
+ * are read, without building the DOM. So are the records of an activity (a
+ * sample per second), which are appended to their columns.
+ *
+ * They return false if the JSON is not valid or it has not a "data" array.
+ * Records with errors are skipped and added to the errors of the dataset.
+ *
+ * The JSON can be a whole string or a ChunkStream, which is parsed while its
+ * chunks are received (they block until the stream is closed).
+ */
+bool parse_json(const std::string& json, StepsData& data);
+bool parse_json(const std::string& json, SleepData& data);
+bool parse_json(const std::string& json, ActivitiesData& data);
+bool parse_json(const std::string& json, RecordsData& data);
+
+/**
+ * Like parse_json(json, data), which only uses it from PARALLEL_PARSE_MIN_SIZE
+ * bytes, but the elements of the data array are always parsed in several
+ * threads. The result is the same as the sequential parse.
+ */
+bool parse_json_parallel(const std::string& json, ActivitiesData& data);
+
+bool parse_json(ChunkStream& stream, StepsData& data);
+bool parse_json(ChunkStream& stream, SleepData& data);
+bool parse_json(ChunkStream& stream, ActivitiesData& data);
+
+} // namespace fitgalgo
+
+#endif // _ES_RGMF_CORE_SAX_H
@@ -0,0 +1,449 @@
+#include "serialize.h"
+
+namespace fitgalgo
+{
+
+// 2: laps cached before have not altitude, grade, temperature... fields.
+constexpr const uint32_t LAPS_FORMAT_VERSION = 2;
+constexpr const uint32_t STEPS_FORMAT_VERSION = 1;
+// 2: sleep levels were cached as strings.
+constexpr const uint32_t SLEEP_FORMAT_VERSION = 2;
+constexpr const uint32_t ACTIVITIES_FORMAT_VERSION = 1;
+
+inline void write(BinaryWriter& w, const DateIdx& idx)
+{
+    w.write(idx.value());
+}
+
+inline void read(BinaryReader& r, DateIdx& idx)
+{
+    std::string value{};
+    r.read(value);
+    idx = DateIdx(value);
+}
+
+inline void write(BinaryWriter& w, const Lap& lap)
+{
+    w.write(lap.message_index);
+    w.write(lap.timestamp);
+    w.write(lap.start_time);
+    w.write(lap.start_lat_lon);
+    w.write(lap.end_lat_lon);
+    w.write(lap.total_elapsed_time);
+    w.write(lap.total_timer_time);
+    w.write(lap.total_moving_time);
+    w.write(lap.total_distance);
+    w.write(lap.avg_speed);
+    w.write(lap.max_speed);
+    w.write(lap.avg_heart_rate);
+    w.write(lap.max_heart_rate);
+    w.write(lap.min_heart_rate);
+    w.write(lap.avg_cadence);
+    w.write(lap.max_cadence);
+    w.write(lap.avg_running_cadence);
+    w.write(lap.max_running_cadence);
+    w.write(lap.total_ascent);
+    w.write(lap.total_descent);
+    w.write(lap.avg_altitude);
+    w.write(lap.max_altitude);
+    w.write(lap.min_altitude);
+    w.write(lap.avg_grade);
+    w.write(lap.avg_pos_grade);
+    w.write(lap.avg_neg_grade);
+    w.write(lap.max_pos_grade);
+    w.write(lap.max_neg_grade);
+    w.write(lap.total_strides);
+    w.write(lap.total_calories);
+    w.write(lap.total_fat_calories);
+    w.write(lap.intensity);
+    w.write(lap.avg_temperature);
+    w.write(lap.max_temperature);
+    w.write(lap.min_temperature);
+    w.write(lap.avg_respiration_rate);
+    w.write(lap.max_respiration_rate);
+}
+
+inline void read(BinaryReader& r, Lap& lap)
+{
+    r.read(lap.message_index);
+    r.read(lap.timestamp);
+    r.read(lap.start_time);
+    r.read(lap.start_lat_lon);
+    r.read(lap.end_lat_lon);
+    r.read(lap.total_elapsed_time);
+    r.read(lap.total_timer_time);
+    r.read(lap.total_moving_time);
+    r.read(lap.total_distance);
+    r.read(lap.avg_speed);
+    r.read(lap.max_speed);
+    r.read(lap.avg_heart_rate);
+    r.read(lap.max_heart_rate);
+    r.read(lap.min_heart_rate);
+    r.read(lap.avg_cadence);
+    r.read(lap.max_cadence);
+    r.read(lap.avg_running_cadence);
+    r.read(lap.max_running_cadence);
+    r.read(lap.total_ascent);
+    r.read(lap.total_descent);
+    r.read(lap.avg_altitude);
+    r.read(lap.max_altitude);
+    r.read(lap.min_altitude);
+    r.read(lap.avg_grade);
+    r.read(lap.avg_pos_grade);
+    r.read(lap.avg_neg_grade);
+    r.read(lap.max_pos_grade);
+    r.read(lap.max_neg_grade);
+    r.read(lap.total_strides);
+    r.read(lap.total_calories);
+    r.read(lap.total_fat_calories);
+    r.read(lap.intensity);
+    r.read(lap.avg_temperature);
+    r.read(lap.max_temperature);
+    r.read(lap.min_temperature);
+    r.read(lap.avg_respiration_rate);
+    r.read(lap.max_respiration_rate);
+}
+
+void serialize(BinaryWriter& writer, const LapsData& data)
+{
+    writer.write(LAPS_FORMAT_VERSION);
+    writer.write(static_cast<uint32_t>(data.laps.size()));
+    for (const auto& lap : data.laps)
+	write(writer, lap);
+    writer.write(data.errors);
+}
+
+bool deserialize(BinaryReader& reader, LapsData& data)
+{
+    uint32_t version{};
+    reader.read(version);
+    if (version != LAPS_FORMAT_VERSION)
+	return false;
+
+    uint32_t size{};
+    reader.read(size);
+    data.laps.clear();
+    for (uint32_t i = 0; i < size && reader.good(); i++)
+	read(reader, data.laps.emplace_back());
+    reader.read(data.errors);
+
+    return reader.good() && reader.at_end();
+}
+
+void serialize(BinaryWriter& writer, const StepsData& data)
+{
+    writer.write(STEPS_FORMAT_VERSION);
+    writer.write(static_cast<uint32_t>(data.steps.size()));
+    for (const auto& [idx, steps] : data.steps)
+    {
+	write(writer, idx);
+	writer.write(steps.datetime_utc);
+	writer.write(steps.datetime_local);
+	writer.write(steps.steps);
+	writer.write(steps.distance);
+	writer.write(steps.calories);
+    }
+    writer.write(data.errors);
+}
+
+bool deserialize(BinaryReader& reader, StepsData& data)
+{
+    uint32_t version{};
+    reader.read(version);
+    if (version != STEPS_FORMAT_VERSION)
+	return false;
+
+    uint32_t size{};
+    reader.read(size);
+    data.steps.clear();
+    for (uint32_t i = 0; i < size && reader.good(); i++)
+    {
+	DateIdx idx{};
+	Steps steps{};
+	read(reader, idx);
+	reader.read(steps.datetime_utc);
+	reader.read(steps.datetime_local);
+	reader.read(steps.steps);
+	reader.read(steps.distance);
+	reader.read(steps.calories);
+	data.steps.insert_or_assign(idx, std::move(steps));
+    }
+    reader.read(data.errors);
+
+    return reader.good();
+}
+
+void serialize(BinaryWriter& writer, const SleepData& data)
+{
+    writer.write(SLEEP_FORMAT_VERSION);
+    writer.write(static_cast<uint32_t>(data.sleep.size()));
+    for (const auto& [idx, sleep] : data.sleep)
+    {
+	write(writer, idx);
+	writer.write(sleep.zone_info);
+	writer.write(sleep.assessment);
+	writer.write(static_cast<uint32_t>(sleep.levels.size()));
+	for (const auto& level : sleep.levels)
+	{
+	    writer.write(level.timestamp);
+	    writer.write(static_cast<uint8_t>(level.stage));
+	}
+	writer.write(sleep.dates);
+    }
+    writer.write(data.errors);
+}
+
+bool deserialize(BinaryReader& reader, SleepData& data)
+{
+    uint32_t version{};
+    reader.read(version);
+    if (version != SLEEP_FORMAT_VERSION)
+	return false;
+
+    uint32_t size{};
+    reader.read(size);
+    data.sleep.clear();
+    for (uint32_t i = 0; i < size && reader.good(); i++)
+    {
+	DateIdx idx{};
+	Sleep sleep{};
+	read(reader, idx);
+	reader.read(sleep.zone_info);
+	reader.read(sleep.assessment);
+	uint32_t levels_size{};
+	reader.read(levels_size);
+	for (uint32_t j = 0; j < levels_size && reader.good(); j++)
+	{
+	    auto& level = sleep.levels.emplace_back();
+	    uint8_t stage{};
+	    reader.read(level.timestamp);
+	    reader.read(stage);
+	    level.stage = static_cast<SleepStage>(stage);
+	}
+	reader.read(sleep.dates);
+	data.sleep.insert_or_assign(idx, std::move(sleep));
+    }
+    reader.read(data.errors);
+
+    return reader.good();
+}
+
+inline void write(BinaryWriter& w, const Activity& a)
+{
+    w.write(a.id);
+    w.write(a.zone_info);
+    w.write(a.username);
+    w.write(a.sport_profile_name);
+    w.write(a.sport);
+    w.write(a.sub_sport);
+    w.write(a.start_lat_lon);
+    w.write(a.end_lat_lon);
+    w.write(a.start_time_utc);
+    w.write(a.total_elapsed_time);
+    w.write(a.total_timer_time);
+    w.write(a.total_work_time);
+    w.write(a.total_distance);
+    w.write(a.avg_speed);
+    w.write(a.max_speed);
+    w.write(a.avg_cadence);
+    w.write(a.max_cadence);
+    w.write(a.avg_running_cadence);
+    w.write(a.max_running_cadence);
+    w.write(a.total_strides);
+    w.write(a.total_calories);
+    w.write(a.total_ascent);
+    w.write(a.total_descent);
+    w.write(a.avg_temperature);
+    w.write(a.max_temperature);
+    w.write(a.min_temperature);
+    w.write(a.avg_respiration_rate);
+    w.write(a.max_respiration_rate);
+    w.write(a.min_respiration_rate);
+    w.write(a.training_load_peak);
+    w.write(a.total_training_effect);
+    w.write(a.total_anaerobic_training_effect);
+}
+
+inline void read(BinaryReader& r, Activity& a)
+{
+    r.read(a.id);
+    r.read(a.zone_info);
+    r.read(a.username);
+    r.read(a.sport_profile_name);
+    r.read(a.sport);
+    r.read(a.sub_sport);
+    r.read(a.start_lat_lon);
+    r.read(a.end_lat_lon);
+    r.read(a.start_time_utc);
+    r.read(a.total_elapsed_time);
+    r.read(a.total_timer_time);
+    r.read(a.total_work_time);
+    r.read(a.total_distance);
+    r.read(a.avg_speed);
+    r.read(a.max_speed);
+    r.read(a.avg_cadence);
+    r.read(a.max_cadence);
+    r.read(a.avg_running_cadence);
+    r.read(a.max_running_cadence);
+    r.read(a.total_strides);
+    r.read(a.total_calories);
+    r.read(a.total_ascent);
+    r.read(a.total_descent);
+    r.read(a.avg_temperature);
+    r.read(a.max_temperature);
+    r.read(a.min_temperature);
+    r.read(a.avg_respiration_rate);
+    r.read(a.max_respiration_rate);
+    r.read(a.min_respiration_rate);
+    r.read(a.training_load_peak);
+    r.read(a.total_training_effect);
+    r.read(a.total_anaerobic_training_effect);
+}
+
+inline void write(BinaryWriter& w, const Split& split)
+{
+    w.write(split.split_type);
+    w.write(split.total_elapsed_time);
+    w.write(split.total_timer_time);
+    w.write(split.start_time);
+    w.write(split.avg_hr);
+    w.write(split.max_hr);
+    w.write(split.total_calories);
+    w.write(split.difficulty);
+    w.write(split.result);
+}
+
+inline void read(BinaryReader& r, Split& split)
+{
+    r.read(split.split_type);
+    r.read(split.total_elapsed_time);
+    r.read(split.total_timer_time);
+    r.read(split.start_time);
+    r.read(split.avg_hr);
+    r.read(split.max_hr);
+    r.read(split.total_calories);
+    r.read(split.difficulty);
+    r.read(split.result);
+}
+
+inline void write(BinaryWriter& w, const Set& set)
+{
+    w.write(set.timestamp);
+    w.write(set.set_type);
+    w.write(set.duration);
+    w.write(set.repetitions);
+    w.write(set.weight);
+    w.write(set.start_time);
+    w.write(set.category);
+    w.write(set.category_subtype);
+    w.write(set.weight_display_unit);
+    w.write(set.message_index);
+    w.write(set.wkt_step_index);
+}
+
+inline void read(BinaryReader& r, Set& set)
+{
+    r.read(set.timestamp);
+    r.read(set.set_type);
+    r.read(set.duration);
+    r.read(set.repetitions);
+    r.read(set.weight);
+    r.read(set.start_time);
+    r.read(set.category);
+    r.read(set.category_subtype);
+    r.read(set.weight_display_unit);
+    r.read(set.message_index);
+    r.read(set.wkt_step_index);
+}
+
+template <typename T>
+inline void write_items(BinaryWriter& w, const std::vector<T>& items)
+{
+    w.write(static_cast<uint32_t>(items.size()));
+    for (const auto& item : items)
+	write(w, item);
+}
+
+template <typename T>
+inline void read_items(BinaryReader& r, std::vector<T>& items)
+{
+    uint32_t size{};
+    r.read(size);
+    items.clear();
+    for (uint32_t i = 0; i < size && r.good(); i++)
+	read(r, items.emplace_back());
+}
+
+void serialize(BinaryWriter& writer, const ActivitiesData& data)
+{
+    writer.write(ACTIVITIES_FORMAT_VERSION);
+    writer.write(static_cast<uint32_t>(data.activities.size()));
+    for (const auto& [idx, a] : data.activities)
+    {
+	write(writer, idx);
+	writer.write(get_type(a));
+	write(writer, as_activity(a));
+	if (const auto distance_a = std::get_if<DistanceActivity>(&a))
+	    write_items(writer, distance_a->laps);
+	else if (const auto splits_a = std::get_if<SplitsActivity>(&a))
+	    write_items(writer, splits_a->splits);
+	else if (const auto sets_a = std::get_if<SetsActivity>(&a))
+	    write_items(writer, sets_a->sets);
+    }
+    writer.write(data.errors);
+}
+
+bool deserialize(BinaryReader& reader, ActivitiesData& data)
+{
+    uint32_t version{};
+    reader.read(version);
+    if (version != ACTIVITIES_FORMAT_VERSION)
+	return false;
+
+    uint32_t size{};
+    reader.read(size);
+    data.activities.clear();
+    for (uint32_t i = 0; i < size && reader.good(); i++)
+    {
+	DateIdx idx{};
+	ActivityType type{};
+	read(reader, idx);
+	reader.read(type);
+
+	AnyActivity activity{};
+	switch (type)
+	{
+	case ActivityType::DISTANCE:
+	{
+	    auto& a = activity.emplace<DistanceActivity>();
+	    read(reader, static_cast<Activity&>(a));
+	    read_items(reader, a.laps);
+	    break;
+	}
+	case ActivityType::SPLITS:
+	{
+	    auto& a = activity.emplace<SplitsActivity>();
+	    read(reader, static_cast<Activity&>(a));
+	    read_items(reader, a.splits);
+	    break;
+	}
+	case ActivityType::SETS:
+	{
+	    auto& a = activity.emplace<SetsActivity>();
+	    read(reader, static_cast<Activity&>(a));
+	    read_items(reader, a.sets);
+	    break;
+	}
+	default:
+	    read(reader, std::get<Activity>(activity));
+	    break;
+	}
+
+	data.activities.insert_or_assign(idx, std::move(activity));
+    }
+    reader.read(data.errors);
+
+    return reader.good();
+}
+
+} // namespace fitgalgo
@@ -0,0 +1,31 @@
+#ifndef _ES_RGMF_CORE_SERIALIZE_H
+#define _ES_RGMF_CORE_SERIALIZE_H 1
+
+#include "api.h"
+#include "../utils/binary.h"
+
+namespace fitgalgo
+{
+
+/**
+ * Binary serialization of the data loaded from the API, used by the local
+ * caches and the offline snapshots.
+ *
+ * deserialize functions return false if the buffer is truncated or it was
+ * written with another format version.
+ */
+void serialize(BinaryWriter& writer, const LapsData& data);
+bool deserialize(BinaryReader& reader, LapsData& data);
+
+void serialize(BinaryWriter& writer, const StepsData& data);
+bool deserialize(BinaryReader& reader, StepsData& data);
+
+void serialize(BinaryWriter& writer, const SleepData& data);
+bool deserialize(BinaryReader& reader, SleepData& data);
+
+void serialize(BinaryWriter& writer, const ActivitiesData& data);
+bool deserialize(BinaryReader& reader, ActivitiesData& data);
+
+} // namespace fitgalgo
+
+#endif // _ES_RGMF_CORE_SERIALIZE_H
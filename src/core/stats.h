@@ -28,40 +28,40 @@ public:
 class AggregatedStats : public Stats
 {
 private:
-    std::unique_ptr<Activity> activity;
+    Activity activity;
 
-    inline void merge(const std::unique_ptr<Activity>& a);
+    inline void merge(const Activity& a);
 
 public:
-    explicit AggregatedStats() : activity{} {}
-    explicit AggregatedStats(const std::map<DateIdx, std::unique_ptr<Activity>>& activities);
+    // Stats of all times: from and to are the dates of the first and the last
+    // activities added.
+    explicit AggregatedStats();
+    explicit AggregatedStats(const FlatMap<DateIdx, AnyActivity>& activities);
     explicit AggregatedStats(
-	const ushort& year, const std::map<DateIdx, std::unique_ptr<Activity>>& activities);
+	const ushort& year, const FlatMap<DateIdx, AnyActivity>& activities);
     explicit AggregatedStats(
 	const ushort& year, const ushort& month,
-	const std::map<DateIdx, std::unique_ptr<Activity>>& activities);
+	const FlatMap<DateIdx, AnyActivity>& activities);
 
-    AggregatedStats(const AggregatedStats& other);
-    AggregatedStats& operator=(const AggregatedStats& other);
-
-    const std::unique_ptr<Activity>& get_stats() const;
+    void add(const DateIdx& idx, const Activity& a);
+    const Activity& get_stats() const;
 };
 
 class SportStats
 {
 private:
-    std::map<std::string, AggregatedStats> stats;
+    std::map<Symbol, AggregatedStats> stats;
 
 public:
     SportStats() = delete;
     explicit SportStats(
-	const ushort& year, const std::map<DateIdx, std::unique_ptr<Activity>>& activities);
+	const ushort& year, const FlatMap<DateIdx, AnyActivity>& activities);
     explicit SportStats(
 	const ushort& year, const ushort& month,
-	const std::map<DateIdx, std::unique_ptr<Activity>>& activities);
+	const FlatMap<DateIdx, AnyActivity>& activities);
 
     bool empty() const;
-    const std::map<std::string, AggregatedStats>& get_stats() const;
+    const std::map<Symbol, AggregatedStats>& get_stats() const;
 };
 
 class StepsStats : public Stats
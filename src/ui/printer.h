@@ -122,7 +122,7 @@ inline void print_sets(const std::vector<Set>& sets)
 		row = {{"Exercise", {}}, {"Duration", {}}, {"Reps", {}}, {"Weight", {}}, {"Resting", {}}};
 		resting_accum = 0;
 	    }
-	    row[0].second = !set.category.empty() ? set.category[0] : "Unknown";
+	    row[0].second = !set.category.empty() ? set.category[0].str() : "Unknown";
 	    row[1].second = time(set.duration);
 	    row[2].second = ivalue(set.repetitions);
 	    row[3].second = set.weight_display_unit.empty() ?
@@ -166,45 +166,46 @@ inline void print_laps_stats(const std::vector<Lap>& laps)
     tabular.print();
 }
 
-inline void print_activities_stats(const std::unique_ptr<Activity>& a)
+inline void print_activities_stats(const AnyActivity& item)
 {
-    print_header(a->sport + " (" + a->sub_sport + ")");
+    const auto& a = as_activity(item);
+
+    print_header(a.sport.str() + " (" + a.sub_sport.str() + ")");
 
     cout << colors::BOLD << colors::RED;
-    print_optional_stat<float>("Work Time", a->total_work_time, time);
+    print_optional_stat<float>("Work Time", a.total_work_time, time);
     cout << colors::RESET << colors::RED;
-    print_optional_stat<float>("Elapsed Time", a->total_elapsed_time, time);
-    print_optional_stat<float>("Timer Time", a->total_timer_time, time);
+    print_optional_stat<float>("Elapsed Time", a.total_elapsed_time, time);
+    print_optional_stat<float>("Timer Time", a.total_timer_time, time);
 
     cout << colors::RESET << colors::CYAN;
-    print_optional_stat<float>("Distance", a->total_distance, distance);
+    print_optional_stat<float>("Distance", a.total_distance, distance);
 
     cout << colors::RESET << colors::MAGENTA;
-    print_optional_stat<float>("Avg Speed", a->avg_speed, speed);
-    print_optional_stat<float>("Max Speed", a->max_speed, speed);
+    print_optional_stat<float>("Avg Speed", a.avg_speed, speed);
+    print_optional_stat<float>("Max Speed", a.max_speed, speed);
 
     cout << colors::RESET << colors::GREEN;
-    print_optional_stat<float>("Ascent", a->total_ascent, elevation);
-    print_optional_stat<float>("Descent", a->total_descent, elevation);
+    print_optional_stat<float>("Ascent", a.total_ascent, elevation);
+    print_optional_stat<float>("Descent", a.total_descent, elevation);
 
     cout << colors::RESET;
-    print_optional_stat<float>("Total Calories", a->total_calories, calories);
-    print_optional_stat<float>("Avg. Temperature", a->avg_temperature, temperature);
-    print_optional_stat<float>("Max. Temperature", a->max_temperature, temperature);
-    print_optional_stat<float>("Min. Temperature", a->min_temperature, temperature);
-    print_optional_stat<float>("Avg. Respiration Rate", a->avg_respiration_rate, value);
-    print_optional_stat<float>("Max. Respiration Rate", a->max_respiration_rate, value);
-    print_optional_stat<float>("Min. Respiration Rate", a->min_respiration_rate, value);
-    print_optional_stat<float>("Training Load Peak", a->training_load_peak, value);
-    print_optional_stat<float>("Total Training Effect", a->total_training_effect, value);
-    print_optional_stat<float>("Total Anaerobic Training Effect", a->total_anaerobic_training_effect, value);
-
-    if (a->get_id() == ActivityType::SETS)
+    print_optional_stat<float>("Total Calories", a.total_calories, calories);
+    print_optional_stat<float>("Avg. Temperature", a.avg_temperature, temperature);
+    print_optional_stat<float>("Max. Temperature", a.max_temperature, temperature);
+    print_optional_stat<float>("Min. Temperature", a.min_temperature, temperature);
+    print_optional_stat<float>("Avg. Respiration Rate", a.avg_respiration_rate, value);
+    print_optional_stat<float>("Max. Respiration Rate", a.max_respiration_rate, value);
+    print_optional_stat<float>("Min. Respiration Rate", a.min_respiration_rate, value);
+    print_optional_stat<float>("Training Load Peak", a.training_load_peak, value);
+    print_optional_stat<float>("Total Training Effect", a.total_training_effect, value);
+    print_optional_stat<float>("Total Anaerobic Training Effect", a.total_anaerobic_training_effect, value);
+
+    if (const auto sets_activity = std::get_if<SetsActivity>(&item))
     {
 	cout << endl;
 	print_subheader("Sets");
-	auto set_activity = static_cast<SetsActivity*>(a.get());
-	print_sets(set_activity->sets);
+	print_sets(sets_activity->sets);
     }
 
     cout << endl;
@@ -218,44 +219,44 @@ inline void print_aggregated_stats(const AggregatedStats& stats)
     cout << value_formatted("From date", date(stats.get_from_year_month_day()), 40) << endl;
     cout << value_formatted("To date", date(stats.get_to_year_month_day()), 40) << endl;
 
-    if (a->total_work_time.has_value())
-	cout << value_formatted("Work Time", time(a->total_work_time.value()), 40) << endl;
-    if (a->total_elapsed_time.has_value())
-	cout << value_formatted("Elapsed Time", time(a->total_elapsed_time.value()), 40) << endl;
-    if (a->total_timer_time.has_value())
-	cout << value_formatted("Timer Time", time(a->total_timer_time.value()), 40) << endl;
-    if (a->total_distance.has_value())
-	cout << value_formatted("Distance", distance(a->total_distance.value()), 40) << endl;
-    if (a->avg_speed.has_value())
-	cout << value_formatted("Avg Speed", speed(a->avg_speed.value()), 40) << endl;
-    if (a->max_speed.has_value())
-	cout << value_formatted("Max Speed", speed(a->max_speed.value()), 40) << endl;
-    if (a->total_ascent.has_value())
-	cout << value_formatted("Ascent", elevation(a->total_ascent.value()), 40) << endl;
-    if (a->total_descent.has_value())
-	cout << value_formatted("Descent", elevation(a->total_descent.value()), 40) << endl;
-    if (a->total_calories.has_value())
-	cout << value_formatted("Calories", calories(a->total_calories.value()), 40) << endl;
-    if (a->avg_temperature.has_value())
-	cout << value_formatted("Avg Temp", temperature(a->avg_temperature.value()), 40) << endl;
-    if (a->max_temperature.has_value())
-	cout << value_formatted("Max Temp", temperature(a->max_temperature.value()), 40) << endl;
-    if (a->min_temperature.has_value())
-	cout << value_formatted("Min Temp", temperature(a->min_temperature.value()), 40) << endl;
-    if (a->avg_respiration_rate.has_value())
-	cout << value_formatted("Avg Resp", value(a->avg_respiration_rate.value()), 40) << endl;
-    if (a->max_respiration_rate.has_value())
-	cout << value_formatted("Max Resp", value(a->max_respiration_rate.value()), 40) << endl;
-    if (a->min_respiration_rate.has_value())
-	cout << value_formatted("Min Resp", value(a->min_respiration_rate.value()), 40) << endl;
-    if (a->training_load_peak.has_value())
-	cout << value_formatted("Load Peak", value(a->training_load_peak.value()), 40) << endl;
-    if (a->total_training_effect.has_value())
-	cout << value_formatted("Train Effect", value(a->total_training_effect.value()), 40)
+    if (a.total_work_time.has_value())
+	cout << value_formatted("Work Time", time(a.total_work_time.value()), 40) << endl;
+    if (a.total_elapsed_time.has_value())
+	cout << value_formatted("Elapsed Time", time(a.total_elapsed_time.value()), 40) << endl;
+    if (a.total_timer_time.has_value())
+	cout << value_formatted("Timer Time", time(a.total_timer_time.value()), 40) << endl;
+    if (a.total_distance.has_value())
+	cout << value_formatted("Distance", distance(a.total_distance.value()), 40) << endl;
+    if (a.avg_speed.has_value())
+	cout << value_formatted("Avg Speed", speed(a.avg_speed.value()), 40) << endl;
+    if (a.max_speed.has_value())
+	cout << value_formatted("Max Speed", speed(a.max_speed.value()), 40) << endl;
+    if (a.total_ascent.has_value())
+	cout << value_formatted("Ascent", elevation(a.total_ascent.value()), 40) << endl;
+    if (a.total_descent.has_value())
+	cout << value_formatted("Descent", elevation(a.total_descent.value()), 40) << endl;
+    if (a.total_calories.has_value())
+	cout << value_formatted("Calories", calories(a.total_calories.value()), 40) << endl;
+    if (a.avg_temperature.has_value())
+	cout << value_formatted("Avg Temp", temperature(a.avg_temperature.value()), 40) << endl;
+    if (a.max_temperature.has_value())
+	cout << value_formatted("Max Temp", temperature(a.max_temperature.value()), 40) << endl;
+    if (a.min_temperature.has_value())
+	cout << value_formatted("Min Temp", temperature(a.min_temperature.value()), 40) << endl;
+    if (a.avg_respiration_rate.has_value())
+	cout << value_formatted("Avg Resp", value(a.avg_respiration_rate.value()), 40) << endl;
+    if (a.max_respiration_rate.has_value())
+	cout << value_formatted("Max Resp", value(a.max_respiration_rate.value()), 40) << endl;
+    if (a.min_respiration_rate.has_value())
+	cout << value_formatted("Min Resp", value(a.min_respiration_rate.value()), 40) << endl;
+    if (a.training_load_peak.has_value())
+	cout << value_formatted("Load Peak", value(a.training_load_peak.value()), 40) << endl;
+    if (a.total_training_effect.has_value())
+	cout << value_formatted("Train Effect", value(a.total_training_effect.value()), 40)
 	     << endl;
-    if (a->total_anaerobic_training_effect.has_value())
+    if (a.total_anaerobic_training_effect.has_value())
 	cout << value_formatted(
-	    "Anaerobic Effect", value(a->total_anaerobic_training_effect.value()), 40)
+	    "Anaerobic Effect", value(a.total_anaerobic_training_effect.value()), 40)
 	     << endl;
 }
 
@@ -1,6 +1,9 @@
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 #include <sys/stat.h>
 #include <unistd.h>
@@ -47,6 +50,59 @@ inline void enable_echo()
     tcsetattr(STDIN_FILENO, TCSANOW, &tty);
 }
 
+/**
+ * It runs the getter of the connection in its own thread and returns the
+ * future result.
+ *
+ * The thread is detached and it works on a copy of the connection (which
+ * shares the client pool), so dropping the future never blocks.
+ */
+template <typename T>
+inline std::shared_future<Result<T>> fetch_async(
+    const Connection& connection, const Result<T> (Connection::*get)() const)
+{
+    std::packaged_task<Result<T>()> task(
+	[connection, get]() -> Result<T> { return (connection.*get)(); });
+    auto future = task.get_future().share();
+    std::thread(std::move(task)).detach();
+    return future;
+}
+
+template <typename T>
+inline const Result<T>& wait_result(const std::shared_future<Result<T>>& future)
+{
+    if (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	cout << "Loading..." << endl;
+    return future.get();
+}
+
+/**
+ * The newest result of a dataset, without waiting for its request when there
+ * is cached data (see Connection::get_cached_steps).
+ *
+ * While the request is in flight the cached snapshot is shown. When the
+ * request finishes it has replaced the snapshot of the connection, so its data
+ * is shown from then on. If the request fails the cached data is still shown
+ * and the request is reset to be tried again.
+ */
+template <typename T>
+inline Result<T> latest_result(std::shared_future<Result<T>>& future, const Result<T>& cached)
+{
+    if (cached.is_valid())
+    {
+	if (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	    return cached;
+	if (!future.get().is_valid())
+	{
+	    std::cerr << "Showing local data: " << future.get().get_error().error_to_string() << endl;
+	    future = {};
+	    return cached;
+	}
+    }
+
+    return wait_result(future);
+}
+
 inline bool Shell::login()
 {
     Result<LoginData> login_result;
@@ -67,16 +123,46 @@ inline bool Shell::login()
     if (login_result.is_valid())
     {
     	cout << "Login okay" << endl;
+	this->prefetch();
     	return true;
     }
     else
     {
     	std::cerr << "Login error" << endl;
     	std::cerr << login_result.get_error().error_to_string() << endl;
+
+	// Without connection, the local snapshots of the user can be used.
+	if (login_result.get_error().get_type() == ErrorType::NotResponse &&
+	    this->connection.open_offline(username))
+	{
+	    cout << "Working offline with local data" << endl;
+	    this->prefetch();
+	    return true;
+	}
+
     	return false;
     }
 }
 
+inline void Shell::prefetch()
+{
+    this->steps_result = fetch_async(this->connection, &Connection::get_steps);
+    this->sleep_result = fetch_async(this->connection, &Connection::get_sleep);
+    this->activities_result = fetch_async(this->connection, &Connection::get_activities);
+}
+
+inline float path_size(const std::filesystem::path& path)
+{
+    if (std::filesystem::is_regular_file(path))
+	return std::filesystem::file_size(path);
+
+    float size = 0;
+    for (const auto& e : std::filesystem::directory_iterator(path))
+	if (e.is_regular_file())
+	    size += e.file_size();
+    return size;
+}
+
 inline void Shell::upload_path() const
 {
     system("clear");
@@ -90,7 +176,9 @@ inline void Shell::upload_path() const
 	    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 	} while (!std::filesystem::exists(path));
 
+	const auto start = std::chrono::steady_clock::now();
 	auto results = this->connection.post_file(path);
+	const std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
 	unsigned short total = 0;
 	unsigned short accepted = 0;
 	for (auto& result : results)
@@ -121,7 +209,15 @@ inline void Shell::upload_path() const
 	    }
 	}
 	cout << endl << "TOTAL: " << total << endl;
-	cout << "ACCEPTED: " << accepted << endl << endl;
+	cout << "ACCEPTED: " << accepted << endl;
+	cout << "TIME: " << unit(elapsed.count(), "s") << endl;
+	if (elapsed.count() > 0)
+	{
+	    cout << "THROUGHPUT: "
+		 << unit(results.size() / elapsed.count(), "files/s") << " | "
+		 << unit(path_size(path) / 1024 / elapsed.count(), "KiB/s") << endl;
+	}
+	cout << endl;
     }
     catch (std::filesystem::filesystem_error& error)
     {
@@ -133,73 +229,91 @@ inline void Shell::upload_path() const
     std::cin.get();
 }
 
-inline void Shell::steps() const
+inline void Shell::steps()
 {
     try
     {
-	auto result = this->connection.get_steps();
+	if (!this->steps_result.valid())
+	    this->steps_result = fetch_async(this->connection, &Connection::get_steps);
+
+	const auto result = latest_result(
+	    this->steps_result, this->connection.get_cached_steps());
 	if (result.is_valid())
 	{
-	    auto ui = fitgalgo::ShellSteps(result.get_data());
+	    auto ui = fitgalgo::ShellSteps(result.get_snapshot());
 	    ui.loop();
 	}
 	else
 	{
 	    std::cerr << result.get_error().error_to_string() << endl;
+	    this->steps_result = {};
 	    cout << endl << "Press Enter to continue...";
 	    std::cin.get();
 	}
     }
     catch (const std::exception& e) {
 	std::cerr << "Error: " << e.what() << endl;
+	this->steps_result = {};
 	cout << endl << "Press Enter to continue...";
 	std::cin.get();
     }
 }
 
-inline void Shell::sleep() const
+inline void Shell::sleep()
 {
     try
     {
-	auto result = this->connection.get_sleep();
+	if (!this->sleep_result.valid())
+	    this->sleep_result = fetch_async(this->connection, &Connection::get_sleep);
+
+	const auto result = latest_result(
+	    this->sleep_result, this->connection.get_cached_sleep());
 	if (result.is_valid())
 	{
-	    auto ui = fitgalgo::ShellSleep(result.get_data());
+	    auto ui = fitgalgo::ShellSleep(result.get_snapshot());
 	    ui.loop();
 	}
 	else
 	{
 	    std::cerr << result.get_error().error_to_string() << endl;
+	    this->sleep_result = {};
 	    cout << endl << "Press Enter to continue...";
 	    std::cin.get();
 	}
     }
     catch (const std::exception& e) {
 	std::cerr << "Error: " << e.what() << endl;
+	this->sleep_result = {};
 	cout << endl << "Press Enter to continue...";
 	std::cin.get();
     }
 }
 
-inline void Shell::activities() const
+inline void Shell::activities()
 {
     try
     {
-	auto result = this->connection.get_activities();
+	if (!this->activities_result.valid())
+	    this->activities_result = fetch_async(this->connection, &Connection::get_activities);
+
+	const auto result = latest_result(
+	    this->activities_result, this->connection.get_cached_activities());
 	if (result.is_valid())
 	{
-	    auto ui = fitgalgo::ShellActivities(result.get_data(), this->connection);
+	    auto ui = fitgalgo::ShellActivities(result.get_snapshot(), this->connection);
 	    ui.loop();
 	}
 	else
 	{
 	    std::cerr << result.get_error().error_to_string() << endl;
+	    this->activities_result = {};
 	    cout << endl << "Press Enter to continue...";
 	    std::cin.get();
 	}
     }
     catch (const std::exception& e) {
 	std::cerr << "Error: " << e.what() << endl;
+	this->activities_result = {};
 	cout << endl << "Press Enter to continue...";
 	std::cin.get();
     }
@@ -212,9 +326,9 @@ void Shell::loop()
     do
     {
 	system("clear");
-	cout << "MENU" << endl;
+	cout << "MENU" << (this->connection.is_offline() ? " (offline)" : "") << endl;
 	cout << "-------------------------------------------" << endl;
-	if (!this->connection.has_token())
+	if (!this->connection.has_token() && !this->connection.is_offline())
 	{
 	    option = '0';
 	}
@@ -242,9 +356,13 @@ void Shell::loop()
 	    break;
 	case '1':
 	    this->connection.logout();
+	    this->steps_result = {};
+	    this->sleep_result = {};
+	    this->activities_result = {};
 	    break;
 	case '2':
 	    this->upload_path();
+	    this->prefetch();
 	    break;
 	case '3':
 	    this->steps();
@@ -409,7 +527,8 @@ void ShellStats::loop()
     } while (c != 'q');
 }
 
-ShellSteps::ShellSteps(const StepsData &steps_data)
+ShellSteps::ShellSteps(std::shared_ptr<const StepsData> steps_data)
+    : data{std::move(steps_data)}
 {
     const std::chrono::time_point now{std::chrono::system_clock::now()};
     const std::chrono::year_month_day ymd{std::chrono::floor<std::chrono::days>(now)};
@@ -417,22 +536,21 @@ ShellSteps::ShellSteps(const StepsData &steps_data)
     year = static_cast<int>(ymd.year());
     month = static_cast<unsigned>(ymd.month());
     day = static_cast<unsigned>(ymd.day());
-    data = steps_data;
 }
 
 void ShellSteps::all_times_stats() const
 {
     print_header("STEPS: ALL TIMES YEARLY STATS");
 
-    if (data.steps.empty())
+    if (data->steps.empty())
     {
 	cout << "There are not steps data to show" << endl;
 	return;
     }
 
-    short current_year = this->data.steps.begin()->first.year();
+    short current_year = this->data->steps.begin()->first.year();
     StepsStats stats{};
-    for (const auto& [idx, steps] : this->data.steps)
+    for (const auto& [idx, steps] : this->data->steps)
     {
 	if (current_year != idx.year())
 	{
@@ -454,22 +572,16 @@ void ShellSteps::year_stats() const
     oss << "STEPS: YEAR DASHBOARD - " << year;
     print_header(oss.str());
 
-    auto itr = std::find_if(
-	this->data.steps.cbegin(),
-	this->data.steps.cend(),
-	[this](const auto& item) { return item.first.year() == this->year; });
-    if (itr == this->data.steps.end())
+    const auto range = year_range(this->data->steps, year);
+    if (range.empty())
     {
 	cout << "There are not data for this date" << endl;
 	return;
     }
 
     StepsStats stats{};
-    while (itr != this->data.steps.end() && itr->first.year() == year)
-    {
-	stats += itr->second;
-	itr++;
-    }
+    for (const auto& [idx, steps] : range)
+	stats += steps;
 
     print_steps_stats(stats);
 }
@@ -484,14 +596,8 @@ void ShellSteps::month_stats() const
     auto first_wd_ymd = calendar.get_first_wd_ymd();
     auto last_wd_ymd = calendar.get_last_wd_ymd();
 
-    auto itr = std::find_if(
-	this->data.steps.cbegin(),
-	this->data.steps.cend(),
-	[this, first_wd_ymd](const auto& item) {
-	    return item.first.ymd() == first_wd_ymd ||
-		(item.first.year() == this->year && item.first.month() == this->month);
-	});
-    if (itr == this->data.steps.end())
+    const auto range = date_range(this->data->steps, first_wd_ymd, last_wd_ymd);
+    if (range.empty())
     {
      	cout << "There are not data for this date " << endl;
      	return;
@@ -501,7 +607,7 @@ void ShellSteps::month_stats() const
     auto weekly_stats = std::map<std::string, StepsStats>();
     size_t week_number = 1;
     size_t month_day = 1;
-    while (itr != this->data.steps.end() && itr->first.ymd() <= last_wd_ymd)
+    for (auto itr = range.begin(); itr != range.end(); ++itr)
     {
 	if (itr->first.month() == month)
 	    all_stats += itr->second;
@@ -520,7 +626,6 @@ void ShellSteps::month_stats() const
 	calendar.add(itr->first.ymd(), s3);
 
 	++month_day;
-	++itr;
     }
 
     calendar.print();
@@ -552,7 +657,8 @@ void ShellSteps::item_by_item_stats() const
     cout << "No implemented yet" << endl;
 }
 
-ShellSleep::ShellSleep(const SleepData &sleep_data)
+ShellSleep::ShellSleep(std::shared_ptr<const SleepData> sleep_data)
+    : data{std::move(sleep_data)}
 {
     const std::chrono::time_point now{std::chrono::system_clock::now()};
     const std::chrono::year_month_day ymd{std::chrono::floor<std::chrono::days>(now)};
@@ -560,22 +666,21 @@ ShellSleep::ShellSleep(const SleepData &sleep_data)
     year = static_cast<int>(ymd.year());
     month = static_cast<unsigned>(ymd.month());
     day = static_cast<unsigned>(ymd.day());
-    data = sleep_data;
 }
 
 void ShellSleep::all_times_stats() const
 {
     print_header("SLEEP: ALL TIMES YEARLY STATS");
 
-    if (this->data.sleep.empty())
+    if (this->data->sleep.empty())
     {
 	cout << "There are not sleep data to show" << endl;
 	return;
     }
 
-    short current_year = this->data.sleep.begin()->first.year();
+    short current_year = this->data->sleep.begin()->first.year();
     SleepStats stats{};
-    for (const auto& [idx, sleep] : this->data.sleep)
+    for (const auto& [idx, sleep] : this->data->sleep)
     {
 	if (current_year != idx.year())
 	{
@@ -597,22 +702,16 @@ void ShellSleep::year_stats() const
     oss << "SLEEP: YEAR DASHBOARD - " << year;
     print_header(oss.str());
 
-    auto itr = std::find_if(
-	this->data.sleep.cbegin(),
-	this->data.sleep.cend(),
-	[this](const auto& item) { return item.first.year() == this->year; });
-    if (itr == this->data.sleep.end())
+    const auto range = year_range(this->data->sleep, year);
+    if (range.empty())
     {
 	cout << "There are not data for this year" << endl;
 	return;
     }
 
     SleepStats stats{};
-    while (itr != this->data.sleep.end() && itr->first.year() == year)
-    {
-	stats += itr->second;
-	itr++;
-    }
+    for (const auto& [idx, sleep] : range)
+	stats += sleep;
 
     print_sleep_stats(stats);
 }
@@ -627,21 +726,15 @@ void ShellSleep::month_stats() const
     auto first_wd_ymd = calendar.get_first_wd_ymd();
     auto last_wd_ymd = calendar.get_last_wd_ymd();
 
-    auto itr = std::find_if(
-	this->data.sleep.cbegin(),
-	this->data.sleep.cend(),
-	[this, first_wd_ymd](const auto& item) {
-	    return item.first.ymd() == first_wd_ymd ||
-		(item.first.year() == this->year && item.first.month() == this->month);
-	});
-    if (itr == this->data.sleep.end())
+    const auto range = date_range(this->data->sleep, first_wd_ymd, last_wd_ymd);
+    if (range.empty())
     {
      	cout << "There are not data for this date " << endl;
      	return;
     }
 
     SleepStats stats{};
-    while (itr != this->data.sleep.end() && itr->first.ymd() <= last_wd_ymd)
+    for (auto itr = range.begin(); itr != range.end(); ++itr)
     {
 	if (itr->first.month() == month)
 	    stats += itr->second;
@@ -683,8 +776,6 @@ void ShellSleep::month_stats() const
 	    calendar.add(itr->first.ymd(), s4);
 	    calendar.add(itr->first.ymd(), s5);
 	}
-
-	itr++;
     }
 
     calendar.print();
@@ -751,8 +842,33 @@ inline std::vector<std::string> activities_stats(const Activity* a)
     return result;
 }
 
-ShellActivities::ShellActivities(const ActivitiesData &activities_data, const Connection &conn)
-    : connection{conn}
+/**
+ * A column per sport, sorted by its name: sports are grouped by their Symbol,
+ * whose order depends on when they were interned.
+ */
+inline void add_sport_stats(Tabular& tabular, const SportStats& sport_stats)
+{
+    using SportItem = std::pair<const Symbol, AggregatedStats>;
+    std::vector<const SportItem*> sports{};
+    for (const auto& item : sport_stats.get_stats())
+	sports.emplace_back(&item);
+    std::sort(sports.begin(), sports.end(), [](const SportItem* a, const SportItem* b) {
+	return a->first.str() < b->first.str();
+    });
+
+    std::string header{};
+    for (const auto* item : sports)
+    {
+	const auto& [sport, s_stats] = *item;
+	header = sport.str() + " (" + std::to_string(s_stats.get_count()) + ")";
+	tabular.add_header(header);
+	tabular.add_values(header, activities_stats(&s_stats.get_stats()));
+    }
+}
+
+ShellActivities::ShellActivities(
+    std::shared_ptr<const ActivitiesData> activities_data, const Connection &conn)
+    : data{std::move(activities_data)}, connection{conn}
 {
     const std::chrono::time_point now{std::chrono::system_clock::now()};
     const std::chrono::year_month_day ymd{std::chrono::floor<std::chrono::days>(now)};
@@ -760,7 +876,6 @@ ShellActivities::ShellActivities(const ActivitiesData &activities_data, const Co
     year = static_cast<int>(ymd.year());
     month = static_cast<unsigned>(ymd.month());
     day = static_cast<unsigned>(ymd.day());
-    data = activities_data;
 }
 
 void ShellActivities::month_stats() const
@@ -769,7 +884,7 @@ void ShellActivities::month_stats() const
     oss << "ACTIVITIES: MONTH DASHBOARD - " << year << ", " << MONTHS_NAMES[month - 1];
     print_header(oss.str());
 
-    auto stats = AggregatedStats(year, month, this->data.activities);
+    auto stats = AggregatedStats(year, month, this->data->activities);
     if (stats.empty())
     {
 	cout << "There are not data for this date" << endl;
@@ -782,10 +897,10 @@ void ShellActivities::month_stats() const
 
     const auto& aggregated = stats.get_stats();
 
-    print_optional_stat<float>("Training Load Peak", aggregated->training_load_peak, value);
-    print_optional_stat<float>("Total Training Effect", aggregated->total_training_effect, value);
+    print_optional_stat<float>("Training Load Peak", aggregated.training_load_peak, value);
+    print_optional_stat<float>("Total Training Effect", aggregated.total_training_effect, value);
     print_optional_stat<float>(
-	"Total Anaerobic Training Effect", aggregated->total_anaerobic_training_effect, value);
+	"Total Anaerobic Training Effect", aggregated.total_anaerobic_training_effect, value);
 
     cout << endl;
 
@@ -793,15 +908,15 @@ void ShellActivities::month_stats() const
     summary.add_row({
 	    {
 		"Distance",
-		aggregated->total_distance.has_value() ? distance(aggregated->total_distance.value()) : "-"
+		aggregated.total_distance.has_value() ? distance(aggregated.total_distance.value()) : "-"
 	    },
 	    {
 		"Work Time",
-		aggregated->total_work_time.has_value() ? time(aggregated->total_work_time.value()) : "-"
+		aggregated.total_work_time.has_value() ? time(aggregated.total_work_time.value()) : "-"
 	    },
 	    {
 		"Calories",
-		aggregated->total_calories.has_value() ? calories(aggregated->total_calories.value()) : "-"
+		aggregated.total_calories.has_value() ? calories(aggregated.total_calories.value()) : "-"
 	    }
 	});
     summary.print();
@@ -809,14 +924,7 @@ void ShellActivities::month_stats() const
     cout << endl;
 
     auto tabular = Tabular();
-    auto sport_stats = SportStats(year, month, this->data.activities);
-    std::string header{};
-    for (const auto& [sport, s_stats] : sport_stats.get_stats())
-    {
-	header = sport + " (" + std::to_string(s_stats.get_count()) + ")";
-	tabular.add_header(header);
-	tabular.add_values(header, activities_stats(s_stats.get_stats().get()));
-    }
+    add_sport_stats(tabular, SportStats(year, month, this->data->activities));
     tabular.print();
 }
 
@@ -826,7 +934,7 @@ void ShellActivities::year_stats() const
     oss << "ACTIVITIES: YEAR DASHBOARD - " << year;
     print_header(oss.str());
 
-    auto stats = AggregatedStats(year, this->data.activities);
+    auto stats = AggregatedStats(year, this->data->activities);
     if (stats.empty())
     {
 	cout << "There are not data for this date" << endl;
@@ -839,10 +947,10 @@ void ShellActivities::year_stats() const
 
     cout << endl;
 
-    print_optional_stat<float>("Training Load Peak", aggregated->training_load_peak, value);
-    print_optional_stat<float>("Total Training Effect", aggregated->total_training_effect, value);
+    print_optional_stat<float>("Training Load Peak", aggregated.training_load_peak, value);
+    print_optional_stat<float>("Total Training Effect", aggregated.total_training_effect, value);
     print_optional_stat<float>(
-	"Total Anaerobic Training Effect", aggregated->total_anaerobic_training_effect, value);
+	"Total Anaerobic Training Effect", aggregated.total_anaerobic_training_effect, value);
 
     cout << endl;
 
@@ -850,15 +958,15 @@ void ShellActivities::year_stats() const
     summary.add_row({
 	    {
 		"Distance",
-		aggregated->total_distance.has_value() ? distance(aggregated->total_distance.value()) : "-"
+		aggregated.total_distance.has_value() ? distance(aggregated.total_distance.value()) : "-"
 	    },
 	    {
 		"Work Time",
-		aggregated->total_work_time.has_value() ? time(aggregated->total_work_time.value()) : "-"
+		aggregated.total_work_time.has_value() ? time(aggregated.total_work_time.value()) : "-"
 	    },
 	    {
 		"Calories",
-		aggregated->total_calories.has_value() ? calories(aggregated->total_calories.value()) : "-"
+		aggregated.total_calories.has_value() ? calories(aggregated.total_calories.value()) : "-"
 	    }
 	});
     summary.print();
@@ -866,14 +974,7 @@ void ShellActivities::year_stats() const
     cout << endl;
 
     auto tabular = Tabular();
-    auto sport_stats = SportStats(year, this->data.activities);
-    std::string header{};
-    for (const auto& [sport, s_stats] : sport_stats.get_stats())
-    {
-	header = sport + " (" + std::to_string(s_stats.get_count()) + ")";
-	tabular.add_header(header);
-	tabular.add_values(header, activities_stats(s_stats.get_stats().get()));
-    }
+    add_sport_stats(tabular, SportStats(year, this->data->activities));
     tabular.print();
 }
 
@@ -881,7 +982,7 @@ void ShellActivities::all_times_stats() const
 {
     print_header("ACTIVITIES STATS");
 
-    const auto stats = AggregatedStats(this->data.activities);
+    const auto stats = AggregatedStats(this->data->activities);
     if (stats.empty())
     {
         cout << "There are not activities to show" << endl;
@@ -897,35 +998,36 @@ void ShellActivities::item_by_item_stats() const
     oss << "ACTIVITIES: " << day << ", " << MONTHS_NAMES[month - 1] << ", " << year;
     print_header(oss.str());
 
-    auto itr = std::find_if(
-	this->data.activities.cbegin(),
-	this->data.activities.cend(),
-	[this](const auto& item) {
-	    return item.first.year() == year &&
-		item.first.month() == month &&
-		item.first.day() == day;
-	});
-    if (itr == this->data.activities.end())
+    const std::chrono::year_month_day ymd{
+	std::chrono::year(year), std::chrono::month(month), std::chrono::day(day)};
+    const auto range = date_range(this->data->activities, ymd, ymd);
+    if (range.empty())
     {
      	cout << "There are not data for this date " << endl;
      	return;
     }
 
-    while (itr != this->data.activities.end() &&
-	   itr->first.year() == year &&
-	   itr->first.month() == month &&
-	   itr->first.day() == day)
+    std::vector<std::string> laps_ids{};
+    for (const auto& [idx, a] : range)
     {
-	print_activities_stats(itr->second);
+        if (get_type(a) == ActivityType::DISTANCE)
+	    laps_ids.emplace_back(as_activity(a).id);
+    }
 
-        if (itr->second->get_id() == ActivityType::DISTANCE)
+    // All the laps of the day are requested at the same time.
+    const auto laps = this->connection.get_activities_laps(laps_ids);
+
+    auto laps_itr = laps.cbegin();
+    for (const auto& [idx, a] : range)
+    {
+	print_activities_stats(a);
+
+        if (get_type(a) == ActivityType::DISTANCE)
 	{
-	    auto laps_data = this->connection.get_activity_laps(itr->second->id);
-	    if (laps_data.is_valid())
-		print_laps_stats(laps_data.get_data().laps);
+	    if (laps_itr->is_valid())
+		print_laps_stats(laps_itr->get_data().laps);
+	    laps_itr++;
 	}
-
-	itr++;
     }
 }
 
@@ -935,33 +1037,27 @@ void ShellActivities::print_calendar() const
     auto first_wd_ymd = calendar.get_first_wd_ymd();
     auto last_wd_ymd = calendar.get_last_wd_ymd();
 
-    auto itr = std::find_if(
-	this->data.activities.cbegin(),
-	this->data.activities.cend(),
-	[this, first_wd_ymd](const auto& item) {
-	    return item.first.ymd() == first_wd_ymd ||
-		(item.first.year() == year && item.first.month() == month);
-	});
-    if (itr == this->data.activities.end())
+    const auto range = date_range(this->data->activities, first_wd_ymd, last_wd_ymd);
+    if (range.empty())
     {
      	cout << "There are not data for this date " << endl;
      	return;
     }
 
-    while (itr != this->data.activities.end() && itr->first.ymd() <= last_wd_ymd)
+    for (const auto& [idx, item] : range)
     {
+	const auto& a = as_activity(item);
 	std::string s{};
-	if (itr->second->get_id() == ActivityType::DISTANCE)
-	    s = itr->second->sport_profile_name +
-		" (" + distance(itr->second->total_distance.value()) + ")";
-	else if (itr->second->total_work_time.has_value())
-	    s = itr->second->sport_profile_name +
-		 " (" + time(itr->second->total_work_time.value()) + ")";
+	if (get_type(item) == ActivityType::DISTANCE)
+	    s = a.sport_profile_name.str() +
+		" (" + distance(a.total_distance.value()) + ")";
+	else if (a.total_work_time.has_value())
+	    s = a.sport_profile_name.str() +
+		 " (" + time(a.total_work_time.value()) + ")";
 	else
-	    s = itr->second->sport_profile_name +
-		 " (" + time(itr->second->total_elapsed_time.value()) + ")";
-	calendar.add(itr->first.ymd(), s);
-	itr++;
+	    s = a.sport_profile_name.str() +
+		 " (" + time(a.total_elapsed_time.value()) + ")";
+	calendar.add(idx.ymd(), s);
     }
 
     calendar.print();
@@ -1,24 +1,40 @@
 #ifndef _ES_RGMF_UI_SHELL_H
 #define _ES_RGMF_UI_SHELL_H 1
 
+#include <future>
+#include <memory>
+
 #include "../core/api.h"
 
 namespace fitgalgo
 {
 
+/**
+ * Main menu of the application.
+ *
+ * After login, steps, sleep and activities are fetched and parsed in the
+ * background (see prefetch()) and every menu entry uses its result instead of
+ * starting a new request. If the user has local snapshots, they are shown at
+ * once while the request is in flight (see latest_result()).
+ */
 class Shell
 {
 private:
     Connection connection;
+    std::shared_future<Result<StepsData>> steps_result;
+    std::shared_future<Result<SleepData>> sleep_result;
+    std::shared_future<Result<ActivitiesData>> activities_result;
 
     inline bool login();
+    inline void prefetch();
     inline void upload_path() const;
-    inline void steps() const;
-    inline void sleep() const;
-    inline void activities() const;
+    inline void steps();
+    inline void sleep();
+    inline void activities();
 
 public:
-    explicit Shell() : connection{} {}
+    explicit Shell()
+	: connection{}, steps_result{}, sleep_result{}, activities_result{} {}
     void loop();
 };
 
@@ -41,7 +57,7 @@ public:
 class ShellSteps : public ShellStats
 {
 private:
-    StepsData data;
+    std::shared_ptr<const StepsData> data;
 
     void all_times_stats() const override;
     void year_stats() const override;
@@ -49,13 +65,13 @@ private:
     void item_by_item_stats() const override;
 
 public:
-    explicit ShellSteps(const StepsData& steps_data);
+    explicit ShellSteps(std::shared_ptr<const StepsData> steps_data);
 };
 
 class ShellSleep : public ShellStats
 {
 private:
-    SleepData data;
+    std::shared_ptr<const SleepData> data;
 
     void all_times_stats() const override;
     void year_stats() const override;
@@ -63,13 +79,13 @@ private:
     void item_by_item_stats() const override;
 
 public:
-    explicit ShellSleep(const SleepData& sleep_data);
+    explicit ShellSleep(std::shared_ptr<const SleepData> sleep_data);
 };
 
 class ShellActivities: public ShellStats
 {
 private:
-    ActivitiesData data;
+    std::shared_ptr<const ActivitiesData> data;
     Connection connection;
 
     void all_times_stats() const override;
@@ -80,7 +96,8 @@ private:
     void print_calendar() const;
 
 public:
-    explicit ShellActivities(const ActivitiesData& activities_data, const Connection& conn);
+    explicit ShellActivities(
+	std::shared_ptr<const ActivitiesData> activities_data, const Connection& conn);
 };
 
 } // namespace fitgalgo
@@ -0,0 +1,175 @@
+#ifndef _ES_RGMF_UTILS_BINARY_H
+#define _ES_RGMF_UTILS_BINARY_H 1
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "symbol.h"
+
+namespace fitgalgo
+{
+
+/**
+ * Helpers to write and read plain values in a compact binary format.
+ *
+ * Values are stored with the native layout and endianness (they are meant for
+ * local caches, not for exchange), strings and vectors are prefixed by their
+ * size as an uint32_t.
+ *
+ * The writer appends everything into a buffer so the file can be written at
+ * once, and the reader works on a buffer read at once.
+ */
+class BinaryWriter
+{
+private:
+    std::string buffer{};
+
+public:
+    template <typename T>
+    requires std::is_trivially_copyable_v<T>
+    void write(const T& v)
+    {
+	buffer.append(reinterpret_cast<const char*>(&v), sizeof(T));
+    }
+
+    void write(const std::string& v)
+    {
+	write(static_cast<uint32_t>(v.size()));
+	buffer.append(v);
+    }
+
+    // Symbols are stored as their strings: ids are not stable between runs.
+    void write(const Symbol& v)
+    {
+	write(v.str());
+    }
+
+    template <typename A, typename B>
+    void write(const std::pair<A, B>& v)
+    {
+	write(v.first);
+	write(v.second);
+    }
+
+    template <typename T>
+    void write(const std::optional<T>& v)
+    {
+	write(v.has_value());
+	if (v.has_value())
+	    write(v.value());
+    }
+
+    template <typename T>
+    void write(const std::vector<T>& v)
+    {
+	write(static_cast<uint32_t>(v.size()));
+	for (const auto& item : v)
+	    write(item);
+    }
+
+    const std::string& data() const { return buffer; }
+};
+
+/**
+ * Reader counterpart of BinaryWriter.
+ *
+ * It never reads past the end of the buffer: once there are not enough bytes
+ * it stops, values are left default and good() returns false.
+ */
+class BinaryReader
+{
+private:
+    const char* cur;
+    const char* end;
+    bool failed{};
+
+    bool has(const size_t n)
+    {
+	if (failed || static_cast<size_t>(end - cur) < n)
+	    failed = true;
+	return !failed;
+    }
+
+public:
+    explicit BinaryReader(const std::string& data)
+	: cur{data.data()}, end{data.data() + data.size()} {}
+
+    template <typename T>
+    requires std::is_trivially_copyable_v<T>
+    void read(T& v)
+    {
+	if (!has(sizeof(T)))
+	{
+	    v = T{};
+	    return;
+	}
+	std::memcpy(&v, cur, sizeof(T));
+	cur += sizeof(T);
+    }
+
+    void read(std::string& v)
+    {
+	uint32_t size{};
+	read(size);
+	if (!has(size))
+	    return;
+	v.assign(cur, size);
+	cur += size;
+    }
+
+    void read(Symbol& v)
+    {
+	uint32_t size{};
+	read(size);
+	if (!has(size))
+	    return;
+	v = Symbol(std::string_view(cur, size));
+	cur += size;
+    }
+
+    template <typename A, typename B>
+    void read(std::pair<A, B>& v)
+    {
+	read(v.first);
+	read(v.second);
+    }
+
+    template <typename T>
+    void read(std::optional<T>& v)
+    {
+	bool has_value{};
+	read(has_value);
+	if (has_value)
+	{
+	    T value{};
+	    read(value);
+	    v = value;
+	}
+	else
+	{
+	    v.reset();
+	}
+    }
+
+    template <typename T>
+    void read(std::vector<T>& v)
+    {
+	uint32_t size{};
+	read(size);
+	v.clear();
+	for (uint32_t i = 0; i < size && good(); i++)
+	    read(v.emplace_back());
+    }
+
+    bool good() const { return !failed; }
+    bool at_end() const { return cur == end; }
+};
+
+} // namespace fitgalgo
+
+#endif // _ES_RGMF_UTILS_BINARY_H
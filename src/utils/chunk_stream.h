@@ -0,0 +1,117 @@
+#ifndef _ES_RGMF_UTILS_CHUNK_STREAM_H
+#define _ES_RGMF_UTILS_CHUNK_STREAM_H 1
+
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+
+namespace fitgalgo
+{
+
+/**
+ * A rapidjson input stream fed with chunks from another thread.
+ *
+ * The producer (i.e. an httplib content receiver) pushes the chunks as they
+ * are received and closes the stream at the end. The consumer (a
+ * rapidjson::Reader in its own thread) waits when it has read all the chunks
+ * until more of them arrive. Once the stream is closed and read, it reads '\0'
+ * as the end of the stream.
+ *
+ * When the consumer finishes, the chunks pushed after that are discarded.
+ */
+class ChunkStream
+{
+public:
+    typedef char Ch;
+
+private:
+    std::mutex mutex{};
+    std::condition_variable ready{};
+    std::deque<std::string> chunks{};
+    bool closed{};
+    bool finished{};
+
+    // Only used by the consumer.
+    std::string current{};
+    size_t position{};
+    size_t consumed{};
+
+    bool next_chunk()
+    {
+	std::unique_lock<std::mutex> lock(mutex);
+	ready.wait(lock, [this]() { return !chunks.empty() || closed; });
+	if (chunks.empty())
+	    return false;
+
+	consumed += current.size();
+	current = std::move(chunks.front());
+	chunks.pop_front();
+	position = 0;
+	return true;
+    }
+
+public:
+    ChunkStream() = default;
+    ChunkStream(const ChunkStream& other) = delete;
+
+    ChunkStream& operator=(const ChunkStream& other) = delete;
+
+    void push(const char* data, const size_t length)
+    {
+	if (length == 0)
+	    return;
+	{
+	    std::lock_guard<std::mutex> lock(mutex);
+	    if (closed || finished)
+		return;
+	    chunks.emplace_back(data, length);
+	}
+	ready.notify_one();
+    }
+
+    void close()
+    {
+	{
+	    std::lock_guard<std::mutex> lock(mutex);
+	    closed = true;
+	}
+	ready.notify_one();
+    }
+
+    void finish()
+    {
+	std::lock_guard<std::mutex> lock(mutex);
+	finished = true;
+	chunks.clear();
+    }
+
+    Ch Peek()
+    {
+	while (position == current.size())
+	    if (!next_chunk())
+		return '\0';
+	return current[position];
+    }
+
+    Ch Take()
+    {
+	const Ch c = Peek();
+	if (position < current.size())
+	    position++;
+	return c;
+    }
+
+    size_t Tell() const { return consumed + position; }
+
+    // It is a read only stream.
+    Ch* PutBegin() { assert(false); return nullptr; }
+    void Put(Ch) { assert(false); }
+    void Flush() { assert(false); }
+    size_t PutEnd(Ch*) { assert(false); return 0; }
+};
+
+} // namespace fitgalgo
+
+#endif // _ES_RGMF_UTILS_CHUNK_STREAM_H
@@ -2,6 +2,9 @@
 #define _ES_RGMF_UTILS_DATE_H 1
 
 #include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string_view>
 
 namespace fitgalgo
 {
@@ -23,17 +26,165 @@ inline ushort last_month_day(const int& year, const ushort& month)
     return unsigned(last_day_of_this_month.day());
 }
 
-inline std::chrono::year_month_day from_isodate_to_ymd(const std::string& iso_date)
+/**
+ * It parses the digits of s[begin, begin + n) without allocating. It returns
+ * -1 if any of them is not a digit.
+ *
+ * All the digits are always read: the invalid ones are accumulated in a mask
+ * instead of breaking the loop, so a fixed n is unrolled without branches.
+ */
+constexpr int parse_digits(const std::string_view s, const size_t begin, const size_t n)
 {
-    std::stringstream ss(iso_date);
-    std::string token;
-    std::getline(ss, token, '/');
-    int year = std::stoi(token);
-    std::getline(ss, token, '/');
-    unsigned int month = std::stoi(token);
-    std::getline(ss, token);
-    unsigned int day = std::stoi(token);
-    return std::chrono::year_month_day{std::chrono::year{year}, std::chrono::month{month}, std::chrono::day{day}};
+    if (begin + n > s.size())
+	return -1;
+
+    int value = 0;
+    unsigned invalid = 0;
+    for (size_t i = begin; i < begin + n; i++)
+    {
+	const unsigned digit = static_cast<unsigned>(s[i]) - '0';
+	invalid |= digit > 9;
+	value = value * 10 + static_cast<int>(digit);
+    }
+    return invalid ? -1 : value;
+}
+
+/**
+ * Fields of a datetime in ISO 8601 format: yyyy-mm-ddThh:mm:ss.
+ */
+struct IsoDateTime
+{
+    int year{};
+    unsigned month{};
+    unsigned day{};
+    unsigned hour{};
+    unsigned minute{};
+    unsigned second{};
+};
+
+/**
+ * Hand-written parsers of the beginning of an ISO 8601 string, without
+ * allocations nor streams. Trailing characters are ignored.
+ *
+ * - parse_isodate: yyyy-mm-dd (or yyyy/mm/dd), with time 00:00:00.
+ * - parse_isodatetime: yyyy-mm-ddThh:mm:ss (or a space instead of T).
+ *
+ * They return nothing if the string has not the format or the date or the time
+ * are not valid.
+ */
+constexpr std::optional<IsoDateTime> parse_isodate(const std::string_view s)
+{
+    if (s.size() < 10 || s[4] != s[7] || (s[4] != '-' && s[4] != '/'))
+	return std::nullopt;
+
+    const int year = parse_digits(s, 0, 4);
+    const int month = parse_digits(s, 5, 2);
+    const int day = parse_digits(s, 8, 2);
+    if ((year | month | day) < 0)
+	return std::nullopt;
+
+    const IsoDateTime dt{year, static_cast<unsigned>(month), static_cast<unsigned>(day)};
+    const std::chrono::year_month_day ymd{
+	std::chrono::year{dt.year}, std::chrono::month{dt.month}, std::chrono::day{dt.day}};
+    if (!ymd.ok())
+	return std::nullopt;
+    return dt;
+}
+
+constexpr std::optional<IsoDateTime> parse_isodatetime(const std::string_view s)
+{
+    if (s.size() < 19 || (s[10] != 'T' && s[10] != ' ') || s[13] != ':' || s[16] != ':' || s[4] != '-')
+	return std::nullopt;
+
+    auto dt = parse_isodate(s);
+    const int hour = parse_digits(s, 11, 2);
+    const int minute = parse_digits(s, 14, 2);
+    const int second = parse_digits(s, 17, 2);
+    if (!dt.has_value() || (hour | minute | second) < 0 || hour > 23 || minute > 59 || second > 60)
+	return std::nullopt;
+
+    dt->hour = hour;
+    dt->minute = minute;
+    dt->second = second;
+    return dt;
+}
+
+/**
+ * It writes dt as yyyy-mm-ddThh:mm:ss (19 characters) into out, without
+ * allocations nor streams.
+ */
+constexpr void format_isodatetime(const IsoDateTime& dt, char* out)
+{
+    const auto digits = [](char* p, unsigned value, const size_t n) {
+	for (size_t i = n; i-- > 0; value /= 10)
+	    p[i] = static_cast<char>('0' + value % 10);
+    };
+
+    digits(out, static_cast<unsigned>(dt.year), 4);
+    out[4] = '-';
+    digits(out + 5, dt.month, 2);
+    out[7] = '-';
+    digits(out + 8, dt.day, 2);
+    out[10] = 'T';
+    digits(out + 11, dt.hour, 2);
+    out[13] = ':';
+    digits(out + 14, dt.minute, 2);
+    out[16] = ':';
+    digits(out + 17, dt.second, 2);
+}
+
+/**
+ * It returns an invalid date (ok() is false) if iso_date is not a date.
+ */
+constexpr std::chrono::year_month_day from_isodate_to_ymd(const std::string_view iso_date)
+{
+    const auto dt = parse_isodate(iso_date);
+    if (!dt.has_value())
+	return std::chrono::year_month_day{};
+    return std::chrono::year{dt->year} / std::chrono::month{dt->month} / std::chrono::day{dt->day};
+}
+
+/**
+ * Seconds since the epoch of an ISO 8601 datetime: yyyy-mm-ddThh:mm:ss with
+ * optional fractional seconds (ignored) and an optional Z or +hh:mm/-hh:mm
+ * offset. Without offset it is taken as UTC.
+ *
+ * It returns nothing if the datetime is not valid.
+ */
+inline std::optional<int64_t> from_isodatetime_to_epoch(const std::string_view iso_datetime)
+{
+    const auto& s = iso_datetime;
+    const auto dt = parse_isodatetime(s);
+    if (!dt.has_value())
+	return std::nullopt;
+
+    size_t i = 19;
+    if (i < s.size() && s[i] == '.')
+	for (i++; i < s.size() && s[i] >= '0' && s[i] <= '9'; i++);
+
+    int offset = 0;
+    if (i < s.size() && s[i] == 'Z')
+    {
+	i++;
+    }
+    else if (i < s.size() && (s[i] == '+' || s[i] == '-'))
+    {
+	const bool has_colon = i + 3 < s.size() && s[i + 3] == ':';
+	const int offset_hour = parse_digits(s, i + 1, 2);
+	const int offset_minute = parse_digits(s, i + (has_colon ? 4 : 3), 2);
+	if (offset_hour < 0 || offset_minute < 0)
+	    return std::nullopt;
+	offset = (s[i] == '+' ? 1 : -1) * (offset_hour * 3600 + offset_minute * 60);
+	i += has_colon ? 6 : 5;
+    }
+    if (i != s.size())
+	return std::nullopt;
+
+    const std::chrono::year_month_day ymd{
+	std::chrono::year{dt->year}, std::chrono::month{dt->month}, std::chrono::day{dt->day}};
+    const auto days = std::chrono::sys_days{ymd}.time_since_epoch().count();
+    return static_cast<int64_t>(days) * 86400 +
+	static_cast<int64_t>(dt->hour * 3600 + dt->minute * 60 + dt->second) - offset;
 }
 
 } // namespace fitgalgo
@@ -0,0 +1,181 @@
+#ifndef _ES_RGMF_UTILS_FLAT_MAP_H
+#define _ES_RGMF_UTILS_FLAT_MAP_H 1
+
+#include <algorithm>
+#include <iterator>
+#include <ranges>
+#include <utility>
+#include <vector>
+
+namespace fitgalgo
+{
+
+/**
+ * A map stored as a vector of (key, value) pairs sorted by key.
+ *
+ * Iterating it streams through contiguous memory instead of chasing the nodes
+ * of a tree, and lookups are binary searches (find, lower_bound and
+ * upper_bound). Its API is the subset of std::map used by the datasets.
+ *
+ * It is meant for data that arrives almost sorted (i.e. time series):
+ * inserting a key bigger than the last one is a push_back, but inserting in
+ * the middle moves the items after it and invalidates iterators.
+ *
+ * Keys must not be modified through the iterators.
+ */
+template <typename K, typename V>
+class FlatMap
+{
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<K, V>;
+    using iterator = typename std::vector<value_type>::iterator;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+    using reverse_iterator = typename std::vector<value_type>::reverse_iterator;
+    using const_reverse_iterator = typename std::vector<value_type>::const_reverse_iterator;
+
+private:
+    std::vector<value_type> items{};
+
+    static bool key_less(const value_type& item, const K& key) { return item.first < key; }
+    static bool less_key(const K& key, const value_type& item) { return key < item.first; }
+
+    // Position of key and if it is there, so it only does one binary search.
+    std::pair<iterator, bool> locate(const K& key)
+    {
+	if (items.empty() || items.back().first < key)
+	    return {items.end(), false};
+	auto itr = lower_bound(key);
+	return {itr, !(key < itr->first)};
+    }
+
+public:
+    iterator begin() { return items.begin(); }
+    iterator end() { return items.end(); }
+    const_iterator begin() const { return items.begin(); }
+    const_iterator end() const { return items.end(); }
+    const_iterator cbegin() const { return items.cbegin(); }
+    const_iterator cend() const { return items.cend(); }
+    reverse_iterator rbegin() { return items.rbegin(); }
+    reverse_iterator rend() { return items.rend(); }
+    const_reverse_iterator rbegin() const { return items.rbegin(); }
+    const_reverse_iterator rend() const { return items.rend(); }
+
+    bool empty() const { return items.empty(); }
+    size_t size() const { return items.size(); }
+    void clear() { items.clear(); }
+    void reserve(const size_t n) { items.reserve(n); }
+
+    iterator lower_bound(const K& key)
+    {
+	return std::lower_bound(items.begin(), items.end(), key, key_less);
+    }
+    const_iterator lower_bound(const K& key) const
+    {
+	return std::lower_bound(items.cbegin(), items.cend(), key, key_less);
+    }
+    iterator upper_bound(const K& key)
+    {
+	return std::upper_bound(items.begin(), items.end(), key, less_key);
+    }
+    const_iterator upper_bound(const K& key) const
+    {
+	return std::upper_bound(items.cbegin(), items.cend(), key, less_key);
+    }
+
+    /**
+     * Items with keys in [from, to), found with two binary searches.
+     */
+    std::ranges::subrange<const_iterator> range(const K& from, const K& to) const
+    {
+	return {lower_bound(from), lower_bound(to)};
+    }
+
+    iterator find(const K& key)
+    {
+	auto itr = lower_bound(key);
+	return itr != items.end() && !(key < itr->first) ? itr : items.end();
+    }
+    const_iterator find(const K& key) const
+    {
+	auto itr = lower_bound(key);
+	return itr != items.cend() && !(key < itr->first) ? itr : items.cend();
+    }
+
+    /**
+     * If every item of other is in this map with an equal value. It is a
+     * binary search per item of other, so it is cheap for a small other.
+     */
+    bool includes(const FlatMap& other) const
+    {
+	return std::all_of(other.begin(), other.end(), [this](const value_type& item) {
+	    const auto itr = find(item.first);
+	    return itr != end() && itr->second == item.second;
+	});
+    }
+
+    V& operator[](const K& key)
+    {
+	auto [itr, found] = locate(key);
+	if (!found)
+	    itr = items.emplace(itr, key, V{});
+	return itr->second;
+    }
+
+    template <typename M>
+    std::pair<iterator, bool> insert_or_assign(const K& key, M&& value)
+    {
+	auto [itr, found] = locate(key);
+	if (found)
+	{
+	    itr->second = std::forward<M>(value);
+	    return {itr, false};
+	}
+	return {items.emplace(itr, key, std::forward<M>(value)), true};
+    }
+
+    /**
+     * It moves the items of other into this map. When a key is in both maps,
+     * the value of this map is kept and the one of other is dropped (unlike
+     * std::map::merge, which leaves it in other): other is always left empty.
+     * It is a linear merge of both sorted vectors.
+     */
+    void merge(FlatMap&& other)
+    {
+	if (other.empty())
+	    return;
+	if (empty() || items.back().first < other.items.front().first)
+	{
+	    items.insert(
+		items.end(),
+		std::make_move_iterator(other.items.begin()),
+		std::make_move_iterator(other.items.end()));
+	    other.clear();
+	    return;
+	}
+
+	std::vector<value_type> merged{};
+	merged.reserve(items.size() + other.items.size());
+	auto l = items.begin(), r = other.items.begin();
+	while (l != items.end() || r != other.items.end())
+	{
+	    if (r == other.items.end() || (l != items.end() && !(r->first < l->first)))
+	    {
+		if (r != other.items.end() && !(l->first < r->first))
+		    r++;
+		merged.emplace_back(std::move(*l++));
+	    }
+	    else
+	    {
+		merged.emplace_back(std::move(*r++));
+	    }
+	}
+	items = std::move(merged);
+	other.clear();
+    }
+};
+
+} // namespace fitgalgo
+
+#endif // _ES_RGMF_UTILS_FLAT_MAP_H
@@ -0,0 +1,35 @@
+#ifndef _ES_RGMF_UTILS_PARALLEL_H
+#define _ES_RGMF_UTILS_PARALLEL_H 1
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace fitgalgo
+{
+
+/**
+ * It calls fn(i) for every i in [0, n) from, at most, max_workers threads.
+ */
+template <typename F>
+void parallel_for(const size_t n, const size_t max_workers, F fn)
+{
+    std::atomic<size_t> next{0};
+    auto worker = [n, &next, &fn]()
+    {
+	for (size_t i = next++; i < n; i = next++)
+	    fn(i);
+    };
+
+    const size_t workers_count = std::min(std::max(max_workers, size_t{1}), n);
+    std::vector<std::thread> workers;
+    for (size_t i = 0; i < workers_count; i++)
+	workers.emplace_back(worker);
+    for (auto& w : workers)
+	w.join();
+}
+
+} // namespace fitgalgo
+
+#endif // _ES_RGMF_UTILS_PARALLEL_H
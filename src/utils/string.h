@@ -1,7 +1,9 @@
 #ifndef _ES_RGMF_UTILS_STRING_H
 #define _ES_RGMF_UTILS_STRING_H 1
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace fitgalgo
 {
@@ -28,6 +30,29 @@ inline size_t mb_strlen(const std::string& s)
     return n;
 }
 
+/**
+ * FNV-1a hash of a string. It can be used at compile time, so it allows to
+ * switch on strings:
+ *
+ *   switch (str_hash(key))
+ *   {
+ *   case str_hash("name"):
+ *       if (key == "name") ...
+ *
+ * Unknown strings could have the same hash than a case, so the string has to
+ * be compared too.
+ */
+constexpr uint64_t str_hash(const std::string_view s)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (const char c : s)
+    {
+	hash ^= static_cast<unsigned char>(c);
+	hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
 } // namespace fitgalgo
 
 #endif // _ES_RGMF_UTILS_STRING_H
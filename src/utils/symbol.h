@@ -0,0 +1,97 @@
+#ifndef _ES_RGMF_UTILS_SYMBOL_H
+#define _ES_RGMF_UTILS_SYMBOL_H 1
+
+#include <compare>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace fitgalgo
+{
+
+/**
+ * Global table of interned strings. Every different string is stored once
+ * and it is identified by a small integer: its position in the table.
+ *
+ * The empty string is always the id 0. Strings are never removed, so the
+ * references returned by get() are valid until the end of the program.
+ *
+ * It is thread safe: datasets are parsed in several threads.
+ */
+class SymbolTable
+{
+private:
+    mutable std::shared_mutex mutex{};
+    std::deque<std::string> strings{std::string{}};
+    std::unordered_map<std::string_view, uint32_t> ids{{std::string_view{}, 0}};
+
+    SymbolTable() = default;
+
+public:
+    SymbolTable(const SymbolTable& other) = delete;
+
+    SymbolTable& operator=(const SymbolTable& other) = delete;
+
+    static SymbolTable& instance()
+    {
+	static SymbolTable table{};
+	return table;
+    }
+
+    uint32_t intern(const std::string_view value)
+    {
+	{
+	    std::shared_lock<std::shared_mutex> lock(mutex);
+	    if (const auto itr = ids.find(value); itr != ids.end())
+		return itr->second;
+	}
+
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	if (const auto itr = ids.find(value); itr != ids.end())
+	    return itr->second;
+	const auto id = static_cast<uint32_t>(strings.size());
+	ids.emplace(strings.emplace_back(value), id);
+	return id;
+    }
+
+    const std::string& get(const uint32_t id) const
+    {
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	return strings[id];
+    }
+};
+
+/**
+ * An interned string: categorical values (sports, sleep levels, set
+ * categories...) that are the same handful of strings repeated in thousands
+ * of items.
+ *
+ * It is the id of the string in the SymbolTable, so it is copied and compared
+ * as an integer. Symbols are ordered by their ids, not alphabetically.
+ *
+ * Ids are only valid while the program runs: store the string (str()) and not
+ * the id.
+ */
+class Symbol
+{
+private:
+    uint32_t id{};
+
+public:
+    Symbol() = default;
+    explicit Symbol(const std::string_view value) : id{SymbolTable::instance().intern(value)} {}
+
+    uint32_t get_id() const { return id; }
+    bool empty() const { return id == 0; }
+    const std::string& str() const { return SymbolTable::instance().get(id); }
+
+    friend auto operator<=>(const Symbol& l, const Symbol& r) = default;
+};
+
+} // namespace fitgalgo
+
+#endif // _ES_RGMF_UTILS_SYMBOL_H
@@ -0,0 +1,365 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <httplib/httplib.h>
+
+#include "../src/core/api.h"
+#include "../src/core/sax.h"
+
+using namespace fitgalgo;
+
+namespace
+{
+
+int failures = 0;
+
+#define CHECK(condition)						\
+    do									\
+    {									\
+	if (!(condition))						\
+	{								\
+	    std::cerr << __FILE__ << ":" << __LINE__			\
+		      << ": CHECK(" #condition ") failed" << std::endl;	\
+	    failures++;							\
+	}								\
+    } while (false)
+
+/**
+ * A local stand-in of the Fit Galgo API. Routes are added to server and then
+ * start() listens in its own thread until the stand-in is destroyed.
+ */
+class StandIn
+{
+private:
+    std::thread thread{};
+    int port{};
+
+public:
+    httplib::Server server{};
+
+    StandIn() = default;
+    StandIn(const StandIn& other) = delete;
+    ~StandIn()
+    {
+	server.stop();
+	if (thread.joinable())
+	    thread.join();
+    }
+
+    StandIn& operator=(const StandIn& other) = delete;
+
+    void start()
+    {
+	port = server.bind_to_any_port("127.0.0.1");
+	thread = std::thread([this]() { server.listen_after_bind(); });
+	server.wait_until_ready();
+    }
+
+    std::string host() const { return "http://127.0.0.1:" + std::to_string(port); }
+};
+
+const std::string STEPS_JSON = R"({"data": [
+    {"datetime_utc": "2024-01-01T00:00:00", "datetime_local": "2024-01-01T00:00:00",
+     "total_steps": 100, "total_distance": 80.0, "total_calories": 10},
+    {"datetime_utc": "2024-01-02T00:00:00", "datetime_local": "2024-01-02T00:00:00",
+     "total_steps": 200, "total_distance": 160.0, "total_calories": 20}
+]})";
+
+/**
+ * The second request of a dataset sends the ETag of the first one and the
+ * 304 answer reuses the cached data, over the same keep-alive connection.
+ */
+void test_not_modified_reuses_cache()
+{
+    StandIn api{};
+    int requests = 0;
+    int not_modified = 0;
+    std::vector<int> ports{};
+    api.server.Get("/monitorings/steps/", [&](const httplib::Request& req, httplib::Response& res) {
+	requests++;
+	ports.emplace_back(req.remote_port);
+	if (req.get_header_value("If-None-Match") == "\"v1\"")
+	{
+	    not_modified++;
+	    res.status = 304;
+	    return;
+	}
+	res.set_header("ETag", "\"v1\"");
+	res.set_content(STEPS_JSON, "application/json");
+    });
+    api.start();
+
+    Connection connection{api.host()};
+    const auto first = connection.get_steps();
+    CHECK(first.is_valid());
+    CHECK(first.get_data().steps.size() == 2);
+
+    const auto second = connection.get_steps();
+    CHECK(second.is_valid());
+    CHECK(requests == 2);
+    CHECK(not_modified == 1);
+    CHECK(second.get_snapshot() == first.get_snapshot());
+    CHECK(ports.size() == 2 && ports[0] == ports[1]);
+}
+
+const std::string STEPS_DELTA_JSON = R"({"data": [
+    {"datetime_utc": "2024-01-02T00:00:00", "datetime_local": "2024-01-02T00:00:00",
+     "total_steps": 250, "total_distance": 200.0, "total_calories": 25},
+    {"datetime_utc": "2024-01-03T00:00:00", "datetime_local": "2024-01-03T00:00:00",
+     "total_steps": 300, "total_distance": 240.0, "total_calories": 30}
+]})";
+
+/**
+ * Once the steps are cached, only the days since the newest one are requested
+ * and merged: the newest day is replaced and the new ones are added. Results
+ * already returned keep their data. A delta already merged does not replace
+ * the cached snapshot.
+ */
+void test_since_merges_delta()
+{
+    StandIn api{};
+    std::vector<std::string> since{};
+    api.server.Get("/monitorings/steps/", [&](const httplib::Request& req, httplib::Response& res) {
+	since.emplace_back(req.get_param_value("since"));
+	res.set_content(req.has_param("since") ? STEPS_DELTA_JSON : STEPS_JSON, "application/json");
+    });
+    api.start();
+
+    Connection connection{api.host()};
+    const auto full = connection.get_steps();
+    CHECK(full.is_valid());
+
+    const auto merged = connection.get_steps();
+    CHECK(merged.is_valid());
+    CHECK(since.size() == 2 && since[0].empty() && since[1] == "2024-01-02T00:00:00");
+
+    const auto& steps = merged.get_data().steps;
+    CHECK(steps.size() == 3);
+    CHECK(steps.find(DateIdx("2024-01-01")) != steps.end());
+    CHECK(steps.find(DateIdx("2024-01-01"))->second.steps == 100);
+    CHECK(steps.find(DateIdx("2024-01-02"))->second.steps == 250);
+    CHECK(steps.find(DateIdx("2024-01-03"))->second.steps == 300);
+    CHECK(full.get_data().steps.size() == 2);
+    CHECK(full.get_data().steps.find(DateIdx("2024-01-02"))->second.steps == 200);
+
+    const auto unchanged = connection.get_steps();
+    CHECK(unchanged.is_valid());
+    CHECK(since.size() == 3 && since[2] == "2024-01-03T00:00:00");
+    CHECK(unchanged.get_snapshot() == merged.get_snapshot());
+}
+
+const std::string STEPS_SECOND_DELTA_JSON = R"({"data": [
+    {"datetime_utc": "2024-01-03T00:00:00", "datetime_local": "2024-01-03T00:00:00",
+     "total_steps": 350, "total_distance": 280.0, "total_calories": 35},
+    {"datetime_utc": "2024-01-04T00:00:00", "datetime_local": "2024-01-04T00:00:00",
+     "total_steps": 400, "total_distance": 320.0, "total_calories": 40}
+]})";
+
+/**
+ * The snapshot saved in the background after two deltas requested back to
+ * back holds the newest data when it is loaded again.
+ */
+void test_snapshot_keeps_newest_delta()
+{
+    StandIn api{};
+    api.server.Post("/auth/login/", [](const httplib::Request&, httplib::Response& res) {
+	res.set_content(R"({"access_token": "token", "token_type": "bearer"})", "application/json");
+    });
+    api.server.Get("/monitorings/steps/", [](const httplib::Request& req, httplib::Response& res) {
+	const auto since = req.get_param_value("since");
+	if (since.empty())
+	    res.set_content(STEPS_JSON, "application/json");
+	else if (since == "2024-01-02T00:00:00")
+	    res.set_content(STEPS_DELTA_JSON, "application/json");
+	else
+	    res.set_content(STEPS_SECOND_DELTA_JSON, "application/json");
+    });
+    api.start();
+
+    {
+	// The saves are waited for when the connection (and its caches) ends.
+	Connection connection{api.host()};
+	CHECK(connection.login("galgo", "secret").is_valid());
+	CHECK(connection.get_steps().is_valid());
+	CHECK(connection.get_steps().is_valid());
+	CHECK(connection.get_steps().get_data().steps.size() == 4);
+    }
+
+    Connection offline{api.host()};
+    CHECK(offline.open_offline("galgo"));
+    const auto cached = offline.get_cached_steps();
+    CHECK(cached.is_valid());
+    const auto& steps = cached.get_data().steps;
+    CHECK(steps.size() == 4);
+    CHECK(steps.find(DateIdx("2024-01-02")) != steps.end());
+    CHECK(steps.find(DateIdx("2024-01-02"))->second.steps == 250);
+    CHECK(steps.find(DateIdx("2024-01-03"))->second.steps == 350);
+    CHECK(steps.find(DateIdx("2024-01-04"))->second.steps == 400);
+}
+
+/**
+ * Records are decoded into their columns. Values missing in a sample are NaN,
+ * 0 or SEMICIRCLES_INVALID.
+ */
+void test_records_columns()
+{
+    StandIn api{};
+    api.server.Get("/activities/42/records/", [](const httplib::Request&, httplib::Response& res) {
+	res.set_content(R"({"data": [
+	    {"timestamp": 1704096000, "position_lat": 477218588, "position_long": -44739243,
+	     "distance": 1.5, "enhanced_speed": 2.5, "heart_rate": 120, "power": 200,
+	     "cadence": 80, "enhanced_altitude": 650.5},
+	    {"timestamp": 1704096001, "speed": 2.0, "heart_rate": 121}
+	]})", "application/json");
+    });
+    api.start();
+
+    Connection connection{api.host()};
+    const auto result = connection.get_activity_records("42");
+    CHECK(result.is_valid());
+
+    const auto& records = result.get_data().records;
+    CHECK(records.size() == 2);
+    CHECK(records.timestamp == std::vector<int64_t>({1704096000, 1704096001}));
+    CHECK(records.position_lat == std::vector<int32_t>({477218588, SEMICIRCLES_INVALID}));
+    CHECK(records.position_long == std::vector<int32_t>({-44739243, SEMICIRCLES_INVALID}));
+    CHECK(std::abs(semicircles_to_degrees(records.position_lat[0]) - 40.0) < 1e-6);
+    CHECK(records.distance[0] == 1.5f && std::isnan(records.distance[1]));
+    CHECK(records.speed == std::vector<float>({2.5f, 2.0f}));
+    CHECK(records.heart_rate == std::vector<int>({120, 121}));
+    CHECK(records.power == std::vector<int>({200, 0}));
+    CHECK(records.cadence == std::vector<int>({80, 0}));
+    CHECK(records.altitude[0] == 650.5f && std::isnan(records.altitude[1]));
+}
+
+const std::string ACTIVITIES_JSON = R"({"data": [
+    {"id": "1", "zone_info": "Europe/Madrid", "username": "galgo",
+     "session": {"sport": "running", "sub_sport": "generic", "start_time": "2024-01-01T08:00:00",
+		 "total_timer_time": 3600.0, "total_distance": 10000.0,
+		 "start_position_lat": 40.0, "start_position_lon": -3.75}},
+    {"id": "2", "zone_info": "Europe/Madrid", "username": "galgo",
+     "session": {"sport": "rock_climbing", "start_time": "2024-01-02T18:00:00",
+		 "total_timer_time": 5400.0},
+     "splits": [{"split_type": "climb_active", "total_timer_time": 300.0, "result": 3},
+		{"split_type": "climb_active", "total_timer_time": 200.0, "result": 1,
+		 "discarded": 1}]},
+    {"id": "3", "zone_info": "Europe/Madrid", "username": "galgo",
+     "session": {"sport": "training", "sub_sport": "strength_training",
+		 "start_time": "2024-01-03T19:00:00", "total_timer_time": 2700.0},
+     "sets": [{"set_type": "active", "duration": 45.0, "repetitions": 10, "weight": 60.0,
+	       "category": [0, "bench_press"], "category_subtype": [1]},
+	      {"set_type": "rest", "duration": 90.0}]},
+    {"id": "4", "session": {"sport": "running", "start_time": "not a date"}},
+    "not an object"
+]})";
+
+/**
+ * Activities parsed from a whole string and from a stream fed in small chunks
+ * are the same, errors included.
+ */
+void test_string_and_stream_parses_agree()
+{
+    ActivitiesData from_string{};
+    const bool string_valid = parse_json(ACTIVITIES_JSON, from_string);
+
+    ChunkStream stream{};
+    for (size_t i = 0; i < ACTIVITIES_JSON.size(); i += 7)
+	stream.push(ACTIVITIES_JSON.data() + i, std::min<size_t>(7, ACTIVITIES_JSON.size() - i));
+    stream.close();
+    ActivitiesData from_stream{};
+    const bool stream_valid = parse_json(stream, from_stream);
+
+    CHECK(string_valid && stream_valid);
+    CHECK(from_string.activities.size() == 3);
+    CHECK(from_string.errors.size() == 2);
+    CHECK(from_string.activities.size() == from_stream.activities.size());
+    CHECK(from_string.includes(from_stream) && from_stream.includes(from_string));
+
+    const auto splits = from_string.activities.find(DateIdx("2024-01-02T18:00:00"));
+    CHECK(splits != from_string.activities.end() && get_type(splits->second) == ActivityType::SPLITS);
+    const auto sets = from_string.activities.find(DateIdx("2024-01-03T19:00:00"));
+    CHECK(sets != from_string.activities.end() && get_type(sets->second) == ActivityType::SETS);
+}
+
+/**
+ * A JSON of many unsorted activities, some with the same start time, and some
+ * errors, to be parsed in several threads.
+ */
+std::string many_activities_json(const std::string& tail)
+{
+    std::string json{R"({"data": [)"};
+    char start_time[32];
+    for (int i = 0; i < 3000; i++)
+    {
+	std::snprintf(start_time, sizeof(start_time), "2023-%02d-%02dT%02d:00:00",
+		      1 + (i * 5) % 12, 1 + (i * 7) % 28, (i * 11) % 24);
+	if (i > 0)
+	    json += ",\n";
+	if (i % 100 == 99)
+	    json += R"("not an object")";
+	else
+	    json += R"({"id": ")" + std::to_string(i) + R"(", "session": {"sport": "running", )"
+		R"("start_time": ")" + start_time + R"(", "total_timer_time": )" +
+		std::to_string(i) + ".0}}";
+    }
+    return json + "]" + tail + "}";
+}
+
+/**
+ * Activities parsed in several threads are the same as parsed in one thread,
+ * including which of the activities with the same start time is kept. JSON
+ * that is invalid after the data array is rejected by both.
+ */
+void test_parallel_and_sequential_parses_agree()
+{
+    const auto json = many_activities_json(R"(, "next": null)");
+    ActivitiesData sequential{};
+    const bool sequential_valid = parse_json(json, sequential);
+    ActivitiesData parallel{};
+    const bool parallel_valid = parse_json_parallel(json, parallel);
+
+    CHECK(sequential_valid && parallel_valid);
+    CHECK(sequential.activities.size() > 1000 && sequential.activities.size() < 2970);
+    CHECK(sequential.errors.size() == 30);
+    CHECK(sequential.activities.size() == parallel.activities.size());
+    CHECK(sequential.errors.size() == parallel.errors.size());
+    CHECK(sequential.includes(parallel) && parallel.includes(sequential));
+
+    const auto invalid = many_activities_json(R"(, "next": })");
+    ActivitiesData sequential_invalid{};
+    ActivitiesData parallel_invalid{};
+    CHECK(!parse_json(invalid, sequential_invalid));
+    CHECK(!parse_json_parallel(invalid, parallel_invalid));
+}
+
+} // namespace
+
+int main()
+{
+    // Snapshots and laps caches are kept out of the user's cache.
+    const auto dir = std::filesystem::temp_directory_path() / "fitgalgo-api-test";
+    setenv("XDG_CACHE_HOME", dir.c_str(), 1);
+
+    test_not_modified_reuses_cache();
+    test_since_merges_delta();
+    test_snapshot_keeps_newest_delta();
+    test_records_columns();
+    test_string_and_stream_parses_agree();
+    test_parallel_and_sequential_parses_agree();
+
+    std::filesystem::remove_all(dir);
+    if (failures > 0)
+    {
+	std::cerr << failures << " checks failed" << std::endl;
+	return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../src/utils/date.h"
+
+using namespace fitgalgo;
+
+namespace
+{
+
+/**
+ * The parse that DateIdx used before parse_isodatetime: std::get_time through
+ * an istringstream, then the same validation of the date.
+ */
+bool parse_with_stream(const std::string& s, IsoDateTime& dt)
+{
+    std::tm tm{};
+    std::istringstream iss(s);
+    iss >> std::get_time(&tm, "%Y-%m-%dT%H:%M:%S");
+    if (iss.fail())
+	return false;
+
+    dt = {tm.tm_year + 1900, static_cast<unsigned>(tm.tm_mon + 1), static_cast<unsigned>(tm.tm_mday),
+	  static_cast<unsigned>(tm.tm_hour), static_cast<unsigned>(tm.tm_min),
+	  static_cast<unsigned>(tm.tm_sec)};
+    const std::chrono::year_month_day ymd{
+	std::chrono::year{dt.year}, std::chrono::month{dt.month}, std::chrono::day{dt.day}};
+    return ymd.ok();
+}
+
+bool parse_hand_written(const std::string& s, IsoDateTime& dt)
+{
+    const auto parsed = parse_isodatetime(s);
+    if (!parsed.has_value())
+	return false;
+    dt = parsed.value();
+    return true;
+}
+
+/**
+ * It parses all the timestamps and returns the milliseconds it takes. The sum
+ * of the fields is kept in checksum so the parses are not optimized away.
+ */
+template <typename Parse>
+double time_parse(const std::vector<std::string>& timestamps, Parse parse, uint64_t& checksum)
+{
+    const auto start = std::chrono::steady_clock::now();
+    IsoDateTime dt{};
+    for (const auto& s : timestamps)
+	if (parse(s, dt))
+	    checksum += dt.year + dt.month + dt.day + dt.hour + dt.minute + dt.second;
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // namespace
+
+/**
+ * Microbenchmark of the ISO 8601 parser: it parses the same millions of
+ * timestamps (one per minute since 2020) with std::get_time and with
+ * parse_isodatetime. Usage: date_bench [number of timestamps]
+ */
+int main(int argc, char* argv[])
+{
+    const size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+
+    std::vector<std::string> timestamps{};
+    timestamps.reserve(n);
+    char formatted[20]{};
+    const std::chrono::sys_seconds first{std::chrono::sys_days{std::chrono::year{2020} / 1 / 1}};
+    for (size_t i = 0; i < n; i++)
+    {
+	const auto t = first + std::chrono::minutes(i);
+	const auto days = std::chrono::floor<std::chrono::days>(t);
+	const std::chrono::year_month_day ymd{days};
+	const std::chrono::hh_mm_ss hms{t - days};
+	format_isodatetime(
+	    {static_cast<int>(ymd.year()), static_cast<unsigned>(ymd.month()),
+	     static_cast<unsigned>(ymd.day()), static_cast<unsigned>(hms.hours().count()),
+	     static_cast<unsigned>(hms.minutes().count()), static_cast<unsigned>(hms.seconds().count())},
+	    formatted);
+	timestamps.emplace_back(formatted);
+    }
+
+    uint64_t stream_checksum = 0;
+    uint64_t hand_written_checksum = 0;
+    const double stream_ms = time_parse(timestamps, parse_with_stream, stream_checksum);
+    const double hand_written_ms = time_parse(timestamps, parse_hand_written, hand_written_checksum);
+    if (stream_checksum != hand_written_checksum)
+    {
+	std::cerr << "The parses do not agree" << std::endl;
+	return EXIT_FAILURE;
+    }
+
+    std::cout << n << " timestamps" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "std::get_time:     " << stream_ms << " ms" << std::endl;
+    std::cout << "parse_isodatetime: " << hand_written_ms << " ms" << std::endl;
+    std::cout << "Speedup:           " << stream_ms / hand_written_ms << "x" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../src/utils/date.h"
+#include "../src/utils/flat_map.h"
+
+using namespace fitgalgo;
+
+namespace
+{
+
+int failures = 0;
+
+#define CHECK(condition)						\
+    do									\
+    {									\
+	if (!(condition))						\
+	{								\
+	    std::cerr << __FILE__ << ":" << __LINE__			\
+		      << ": CHECK(" #condition ") failed" << std::endl;	\
+	    failures++;							\
+	}								\
+    } while (false)
+
+using Map = FlatMap<int, std::string>;
+
+std::vector<std::pair<int, std::string>> items_of(const Map& map)
+{
+    return {map.begin(), map.end()};
+}
+
+Map map_of(const std::vector<std::pair<int, std::string>>& items)
+{
+    Map map{};
+    for (const auto& [key, value] : items)
+	map.insert_or_assign(key, value);
+    return map;
+}
+
+/**
+ * Merging keeps the keys sorted, keeps the value of this map when a key is in
+ * both and always leaves other empty.
+ */
+void test_flat_map_merge()
+{
+    Map interleaved = map_of({{1, "a"}, {3, "c"}, {5, "e"}});
+    Map other = map_of({{2, "b"}, {3, "other"}, {6, "f"}});
+    interleaved.merge(std::move(other));
+    CHECK(items_of(interleaved) == items_of(map_of({{1, "a"}, {2, "b"}, {3, "c"}, {5, "e"}, {6, "f"}})));
+    CHECK(other.empty());
+
+    Map appended = map_of({{1, "a"}});
+    Map after = map_of({{2, "b"}, {3, "c"}});
+    appended.merge(std::move(after));
+    CHECK(items_of(appended) == items_of(map_of({{1, "a"}, {2, "b"}, {3, "c"}})));
+    CHECK(after.empty());
+
+    Map prepended = map_of({{5, "e"}});
+    Map before = map_of({{1, "a"}, {5, "other"}});
+    prepended.merge(std::move(before));
+    CHECK(items_of(prepended) == items_of(map_of({{1, "a"}, {5, "e"}})));
+    CHECK(before.empty());
+
+    Map empty{};
+    Map all = map_of({{1, "a"}, {2, "b"}});
+    empty.merge(std::move(all));
+    CHECK(items_of(empty) == items_of(map_of({{1, "a"}, {2, "b"}})));
+    CHECK(all.empty());
+
+    Map none{};
+    empty.merge(std::move(none));
+    CHECK(empty.size() == 2);
+}
+
+/**
+ * A map includes other if all the items of other are in it with equal values.
+ */
+void test_flat_map_includes()
+{
+    const Map map = map_of({{1, "a"}, {2, "b"}, {3, "c"}});
+    CHECK(map.includes(Map{}));
+    CHECK(map.includes(map_of({{1, "a"}, {3, "c"}})));
+    CHECK(!map.includes(map_of({{1, "a"}, {3, "other"}})));
+    CHECK(!map.includes(map_of({{4, "d"}})));
+}
+
+/**
+ * Dates and datetimes in the accepted formats are parsed into their fields.
+ */
+void test_parse_valid_dates()
+{
+    const auto date = parse_isodate("2024-02-29");
+    CHECK(date.has_value() && date->year == 2024 && date->month == 2 && date->day == 29);
+    CHECK(date->hour == 0 && date->minute == 0 && date->second == 0);
+    CHECK(parse_isodate("2024/01/31").has_value());
+    CHECK(parse_isodate("2024-01-31T10:00:00").has_value());
+
+    const auto datetime = parse_isodatetime("2024-01-31T23:59:60");
+    CHECK(datetime.has_value() && datetime->day == 31 && datetime->hour == 23);
+    CHECK(datetime->minute == 59 && datetime->second == 60);
+    CHECK(parse_isodatetime("2024-01-31 08:30:00").has_value());
+
+    char formatted[20]{};
+    format_isodatetime(parse_isodatetime("2024-03-05T07:08:09").value(), formatted);
+    CHECK(std::string(formatted) == "2024-03-05T07:08:09");
+
+    CHECK(from_isodatetime_to_epoch("2024-01-01T00:00:00") == 1704067200);
+    CHECK(from_isodatetime_to_epoch("2024-01-01T00:00:00.250Z") == 1704067200);
+    CHECK(from_isodatetime_to_epoch("2024-01-01T01:00:00+01:00") == 1704067200);
+    CHECK(from_isodatetime_to_epoch("2023-12-31T23:00:00-0100") == 1704067200);
+}
+
+/**
+ * Dates that do not exist, times out of range and malformed strings are
+ * rejected.
+ */
+void test_parse_invalid_dates()
+{
+    CHECK(!parse_isodate("2024-02-30").has_value());
+    CHECK(!parse_isodate("2023-02-29").has_value());
+    CHECK(!parse_isodate("2024-13-01").has_value());
+    CHECK(!parse_isodate("2024-00-10").has_value());
+    CHECK(!parse_isodate("2024-01-00").has_value());
+    CHECK(!parse_isodate("2024-01/01").has_value());
+    CHECK(!parse_isodate("2024-1-01").has_value());
+    CHECK(!parse_isodate("2024-01-0a").has_value());
+    CHECK(!parse_isodate("2024-01").has_value());
+    CHECK(!parse_isodate("").has_value());
+    CHECK(!from_isodate_to_ymd("2024-02-30").ok());
+
+    CHECK(!parse_isodatetime("2024-01-01T24:00:00").has_value());
+    CHECK(!parse_isodatetime("2024-01-01T23:60:00").has_value());
+    CHECK(!parse_isodatetime("2024-01-01T23:59:61").has_value());
+    CHECK(!parse_isodatetime("2024-02-30T10:00:00").has_value());
+    CHECK(!parse_isodatetime("2024/01/01T10:00:00").has_value());
+    CHECK(!parse_isodatetime("2024-01-01X10:00:00").has_value());
+    CHECK(!parse_isodatetime("2024-01-01T10:00").has_value());
+    CHECK(!parse_isodatetime("2024-01-01T1a:00:00").has_value());
+
+    CHECK(!from_isodatetime_to_epoch("2024-01-01T24:00:00").has_value());
+    CHECK(!from_isodatetime_to_epoch("2024-01-01T00:00:00 ").has_value());
+    CHECK(!from_isodatetime_to_epoch("2024-01-01T00:00:00+1").has_value());
+}
+
+} // namespace
+
+int main()
+{
+    test_flat_map_merge();
+    test_flat_map_includes();
+    test_parse_valid_dates();
+    test_parse_invalid_dates();
+
+    if (failures > 0)
+    {
+	std::cerr << failures << " checks failed" << std::endl;
+	return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}